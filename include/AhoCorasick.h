@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "PackedSequence.h"
+#include "SequenceLoader.h"
+
+using namespace std;
+
+struct Motif {
+    string name;
+    string pattern;
+};
+
+// Multi-pattern matcher over A/C/G/T with a dense 4-way transition table
+// (failure links folded in), so scanning costs one table lookup per base.
+// N bases reset the automaton; patterns may only contain A/C/G/T. For the
+// minus strand the reverse complement of every motif is added to the same
+// automaton, so both strands are found in one pass over the forward text.
+class AhoCorasick {
+private:
+    vector<int32_t> transitions;    // 4 per state
+    vector<int32_t> fail;
+    vector<int32_t> terminal;       // first entry ending at the state, or -1
+    vector<int32_t> outputLink;     // nearest proper suffix state with an entry, or -1
+    vector<int32_t> nextSame;       // next entry with identical sequence, or -1
+    vector<Motif> motifs;           // entry e is motif e % size(), minus strand if e >= size()
+    bool built;
+
+    int32_t newState();
+    void insert(const string& pattern, int32_t entry);
+
+    template <typename Fn>
+    void report(int32_t state, size_t end, Fn& onMatch) const {
+        if (terminal[state] < 0) state = outputLink[state];
+        while (state >= 0) {
+            for (int32_t e = terminal[state]; e >= 0; e = nextSame[e]) {
+                size_t motif = static_cast<size_t>(e) % motifs.size();
+                char strand = static_cast<size_t>(e) < motifs.size() ? '+' : '-';
+                onMatch(end + 1 - motifs[motif].pattern.size(), motif, strand);
+            }
+            state = outputLink[state];
+        }
+    }
+
+public:
+    AhoCorasick();
+
+    void clear();
+    bool addPattern(const string& pattern, const string& name = "");
+    void build(bool plusStrand = true, bool minusStrand = false);
+
+    bool isBuilt() const { return built; }
+    size_t patternCount() const { return motifs.size(); }
+    size_t stateCount() const { return fail.size(); }
+    const Motif& getMotif(size_t index) const { return motifs[index]; }
+    size_t memoryUsage() const;
+
+    // Calls onMatch(startPosition, motifIndex, strand) for every occurrence, in
+    // order of end position; a palindromic motif is reported on both strands.
+    // The automaton restarts at each of the ranges (the records in text), so
+    // no match spans two records.
+    template <typename Fn>
+    void scan(const PackedSequence& text, const vector<RecordRange>& ranges, Fn&& onMatch) const {
+        for (const RecordRange& range : ranges) {
+            int32_t state = 0;
+            text.forEachSymbol(range.begin, range.end, [&](size_t pos, int symbol) {
+                if (symbol > 3) {
+                    state = 0;
+                    return;
+                }
+                state = transitions[state * 4 + symbol];
+                if (terminal[state] >= 0 || outputLink[state] >= 0) {
+                    report(state, pos, onMatch);
+                }
+            });
+        }
+    }
+
+    // Per motif, over the strands the automaton was built for.
+    vector<size_t> countMatches(const PackedSequence& text, const vector<RecordRange>& ranges) const;
+
+    static bool loadMotifs(const string& filename, AhoCorasick& automaton, size_t& skipped);
+};
\ No newline at end of file
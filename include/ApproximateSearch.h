@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class PackedSequence;
+struct RecordRange;
+
+struct ApproxMatch {
+    size_t start;      // 0-based, inclusive
+    size_t end;        // 0-based, inclusive
+    int distance;
+};
+
+// Bit-parallel approximate matching. Hamming mode uses Shift-Or with one
+// state vector per allowed mismatch; edit mode uses Myers' bit-vector
+// algorithm. Patterns longer than 64 bases are split across several words.
+class ApproximateSearch {
+public:
+    enum Mode { HAMMING, EDIT };
+
+    static vector<ApproxMatch> hamming(const string& text, const string& pat, int maxMismatches);
+    static vector<ApproxMatch> hamming(const PackedSequence& text, const string& pat, int maxMismatches);
+    static vector<ApproxMatch> edit(const string& text, const string& pat, int maxDistance);
+    static vector<ApproxMatch> edit(const PackedSequence& text, const string& pat, int maxDistance);
+
+    // Matches stay inside one of the ranges (the records in text, relative to it).
+    static vector<ApproxMatch> search(Mode mode, const PackedSequence& text, const vector<RecordRange>& ranges,
+        const string& pat, int maxDistance);
+    static vector<ApproxMatch> searchParallel(Mode mode, const PackedSequence& text,
+        const vector<RecordRange>& ranges, const string& pat, int maxDistance, unsigned threadCount = 0);
+};
\ No newline at end of file
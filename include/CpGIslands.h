@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class PackedSequence;
+class BufferedWriter;
+struct FastaRecord;
+struct RecordRange;
+
+// Gardiner-Garden and Frommer (1987) thresholds.
+struct CpGIslandParams {
+    size_t window = 200;
+    size_t minLength = 200;
+    double minGcPercent = 50.0;
+    double minObsExp = 0.6;     // CpG * length / (C * G)
+};
+
+struct CpGIsland {
+    size_t record;      // index into the records the ranges came from
+    size_t start;       // relative to the scanned sequence
+    size_t end;
+    size_t cpg = 0;
+    size_t c = 0;
+    size_t g = 0;
+
+    size_t length() const { return end - start; }
+    double gcPercent() const { return (c + g) * 100.0 / length(); }
+    double obsExp() const { return c == 0 || g == 0 ? 0.0 : static_cast<double>(cpg) * length() / (c * g); }
+};
+
+// Slides a window one base at a time, updating C, G and CpG counts as bases
+// enter and leave, and merges overlapping qualifying windows into islands;
+// each merged island must then meet the thresholds as a whole. Windows with an
+// N never qualify. Each thread takes a chunk of window starts and reads
+// window-1 bases past the last one, and islands touching across chunks are
+// joined afterwards.
+class CpGIslands {
+public:
+    static vector<CpGIsland> find(const PackedSequence& seq, const vector<RecordRange>& ranges,
+        const CpGIslandParams& params = CpGIslandParams(), unsigned threadCount = 1);
+
+    // UCSC cpgIslandExt-style BED: name "CpG: n", then length, CpG count,
+    // C+G count, % CpG, % GC and observed/expected ratio.
+    static void writeBed(const vector<CpGIsland>& islands, const vector<FastaRecord>& records,
+        size_t storeOffset, BufferedWriter& out);
+};
\ No newline at end of file
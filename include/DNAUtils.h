@@ -1,15 +1,30 @@
 #pragma once
 #include <string>
 #include <bitset>
+#include <vector>
+#include "PackedSequence.h"
 
 using namespace std;
 
+struct RecordRange;
+
 class DNAUtils {
 public:
+    static char complement(char base);
     static double gcContent(const string& seq);
     static bool containsSRY(const string& seq);
     static string reverseComplement(const string& seq);
+    static void reverseComplementInPlace(string& seq);
     static bool isValidDNA(const string& seq);
     static bool quickValidation(const string& seq);
     static size_t sequenceHash(const string& seq);
+
+    static double gcContent(const PackedSequence& seq);
+    // Looks inside each of the ranges (the records in seq) only.
+    static bool containsSRY(const PackedSequence& seq, const vector<RecordRange>& ranges);
+    static PackedSequence reverseComplement(const PackedSequence& seq);
+    static void reverseComplementInPlace(PackedSequence& seq);
+    static bool isValidDNA(const PackedSequence& seq);
+    static bool quickValidation(const PackedSequence& seq);
+    static size_t sequenceHash(const PackedSequence& seq);
 };
\ No newline at end of file
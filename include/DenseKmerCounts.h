@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Counter array indexed directly by the 2-bit k-mer code (4^k slots). Only the
+// vector matching the chosen counter width is allocated.
+class DenseKmerCounts {
+private:
+    vector<uint8_t> counts8;
+    vector<uint16_t> counts16;
+    vector<uint32_t> counts32;
+    vector<uint64_t> counts64;
+    int k;
+    int width;
+
+public:
+    DenseKmerCounts();
+    DenseKmerCounts(int k, size_t maxCount);
+
+    static int counterWidth(size_t maxCount);
+    static size_t requiredBytes(int k, size_t maxCount);
+
+    uint64_t get(uint64_t code) const;
+    size_t slotCount() const;
+    size_t distinct() const;
+
+    int getK() const { return k; }
+    int getWidth() const { return width; }
+    bool empty() const { return slotCount() == 0; }
+    size_t memoryUsage() const;
+
+    uint8_t* data8() { return counts8.data(); }
+    uint16_t* data16() { return counts16.data(); }
+    uint32_t* data32() { return counts32.data(); }
+    uint64_t* data64() { return counts64.data(); }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        size_t slots = slotCount();
+        for (size_t code = 0; code < slots; code++) {
+            uint64_t count = get(code);
+            if (count != 0) fn(static_cast<uint64_t>(code), count);
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class MatchSink;
+class PackedSequence;
+
+// Boyer-Moore variants tuned for the four-letter alphabet. All shift tables
+// are flat arrays. With only four symbols a single-character shift rarely
+// skips far, so the q-gram variant shifts on the last q bases of the window
+// (q = 2-4 by pattern length, at most 256 table entries) and verifies only
+// when that q-gram ends the pattern.
+class DnaBoyerMoore {
+public:
+    // Byte kernels: report offset + i for every match starting at text[i];
+    // false if the sink stopped the search.
+    static bool horspool(const char* text, size_t length, const string& pat, size_t offset, MatchSink& sink);
+    static bool goodSuffix(const char* text, size_t length, const string& pat, size_t offset, MatchSink& sink);
+    static bool qgram(const char* text, size_t length, const string& pat, size_t offset, MatchSink& sink);
+
+    // Reads each q-gram directly from the 2-bit words and verifies a candidate
+    // one word (32 bases) at a time, so the packed text is never decoded.
+    static bool qgram(const PackedSequence& text, const string& pat, MatchSink& sink);
+    // Same over [begin, end) only, reporting positions relative to begin.
+    static bool qgram(const PackedSequence& text, size_t begin, size_t end, const string& pat,
+        MatchSink& sink);
+
+    static unsigned qgramLength(size_t patternLength);
+};
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "MappedFile.h"
+
+using namespace std;
+
+class PackedSequence;
+
+// FM-index over the alphabet $ < A < C < G < T < N. The BWT is stored at
+// 2 bits per row with N and $ rows flagged in a separate bit vector; rank
+// checkpoints every 256 rows and suffix array samples every `sampleRate`
+// text positions. The in-memory image and the file format are identical,
+// so a saved index is mapped and queried without a load step.
+class FMIndex {
+public:
+    struct Header {
+        char magic[8];
+        uint64_t length;
+        uint64_t sampleRate;
+        uint64_t dollarRow;
+        uint64_t textHash;
+        uint64_t sampleCount;
+        uint64_t symbolCounts[5];
+    };
+
+    static constexpr size_t RANK_BLOCK = 256;
+    static constexpr unsigned DEFAULT_SAMPLE_RATE = 32;
+
+private:
+    vector<uint64_t> storage;
+    MappedFile mapped;
+    const Header* header;
+    const uint64_t* bwt;
+    const uint64_t* special;
+    const uint32_t* rankBlocks;
+    const uint64_t* sampled;
+    const uint32_t* sampledRank;
+    const uint32_t* samples;
+    size_t rows;
+    size_t imageBytes;
+    uint64_t C[6];
+
+    static size_t layout(size_t rows, size_t sampleCount, size_t offsets[7]);
+    void attach(const char* base);
+    size_t rank(int symbol, size_t row) const;
+    int symbolAt(size_t row) const;
+    bool isSampled(size_t row) const { return (sampled[row >> 6] >> (row & 63)) & 1; }
+
+public:
+    FMIndex();
+
+    FMIndex(const FMIndex&) = delete;
+    FMIndex& operator=(const FMIndex&) = delete;
+
+    bool build(const PackedSequence& text, unsigned sampleRate = DEFAULT_SAMPLE_RATE);
+    bool save(const string& filename) const;
+    bool load(const string& filename);
+    void clear();
+
+    bool isBuilt() const { return header != nullptr; }
+    bool matches(const PackedSequence& text) const;
+    size_t size() const { return isBuilt() ? static_cast<size_t>(header->length) : 0; }
+    unsigned getSampleRate() const { return isBuilt() ? static_cast<unsigned>(header->sampleRate) : 0; }
+    size_t memoryUsage() const { return imageBytes; }
+
+    pair<size_t, size_t> findRange(const string& pat) const;
+    size_t count(const string& pat) const;
+    size_t locateRow(size_t row) const;
+    vector<uint64_t> locate(const string& pat) const;
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class PackedSequence;
+class BufferedWriter;
+struct FastaRecord;
+
+struct GcWindow {
+    size_t start;       // relative to the profiled sequence
+    size_t end;
+    uint32_t g = 0;
+    uint32_t c = 0;
+    uint32_t bases = 0; // non-N bases
+
+    double gcPercent() const { return bases == 0 ? 0.0 : (g + c) * 100.0 / bases; }
+    double skew() const { return g + c == 0 ? 0.0 : (static_cast<double>(g) - c) / (g + c); }
+};
+
+// Sliding-window GC% and GC skew (G-C)/(G+C). Window counts come from popcounts
+// over the packed words; overlapping windows are updated incrementally by
+// removing the bases that left and adding the ones that entered. Windows never
+// cross a record boundary, and the last window of a record may be shorter.
+class GcProfile {
+public:
+    enum Format { BEDGRAPH, WIG };
+
+    // Windows starting at begin, begin+step, ... within [begin, end).
+    static vector<GcWindow> compute(const PackedSequence& seq, size_t begin, size_t end,
+        size_t window, size_t step);
+
+    // Writes the GC% and/or skew track (either writer may be null) for seq, which
+    // starts at storeOffset in the store described by records. Windows with no
+    // A/C/G/T are left out. Returns the number of windows written.
+    static size_t write(const PackedSequence& seq, const vector<FastaRecord>& records,
+        size_t storeOffset, size_t window, size_t step, Format format,
+        BufferedWriter* gcOut, BufferedWriter* skewOut, unsigned threadCount = 1);
+};
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+struct HeavyHitter {
+    uint64_t code;
+    uint64_t count;   // upper bound on the true count
+    uint64_t error;   // count - error is a lower bound
+};
+
+// Space-Saving summary over 2-bit k-mer codes with a fixed number of counters.
+// Every key whose true frequency exceeds total / capacity is guaranteed to be kept.
+class SpaceSaving {
+private:
+    vector<HeavyHitter> heap;                 // min-heap on count
+    unordered_map<uint64_t, size_t> position; // code -> heap index
+    size_t capacity;
+    uint64_t total;
+
+    void siftDown(size_t i);
+    void swapEntries(size_t a, size_t b);
+
+public:
+    static const size_t BYTES_PER_COUNTER = 64;
+
+    explicit SpaceSaving(size_t capacity);
+
+    void add(uint64_t code);
+    vector<HeavyHitter> top(size_t n) const;
+
+    size_t getCapacity() const { return capacity; }
+    size_t size() const { return heap.size(); }
+    uint64_t getTotal() const { return total; }
+    uint64_t maxError() const { return heap.size() < capacity || heap.empty() ? 0 : heap[0].count; }
+};
\ No newline at end of file
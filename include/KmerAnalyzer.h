@@ -4,12 +4,43 @@
 #include <vector>
 #include <queue>
 #include <functional>
+#include "KmerTable.h"
+#include "DenseKmerCounts.h"
+#include "HeavyHitters.h"
 
 using namespace std;
 
+class PackedSequence;
+struct RecordRange;
+
+// The packed-sequence forms count only k-mers inside one of the ranges (the
+// records in seq, relative to it), so no k-mer joins two records.
 class KmerAnalyzer {
 public:
     static unordered_map<string, int> count(const string& seq, int k);
+    static unordered_map<string, int> count(const PackedSequence& seq, const vector<RecordRange>& ranges, int k,
+        bool canonical = false);
     static vector<pair<string, int>> topKmers(const unordered_map<string, int>& kmers, int n);
     static vector<pair<string, int>> topKmersHeap(const unordered_map<string, int>& kmers, int n);
+
+    static KmerTable countEncoded(const string& seq, int k, bool canonical = false);
+    static KmerTable countEncoded(const PackedSequence& seq, const vector<RecordRange>& ranges, int k,
+        bool canonical = false);
+    // Disjoint hash partitions: every k-mer is counted in exactly one table.
+    static vector<KmerTable> countParallel(const PackedSequence& seq, const vector<RecordRange>& ranges, int k,
+        unsigned threadCount = 0, bool canonical = false);
+    static vector<pair<string, int>> topKmers(const KmerTable& kmers, int n);
+    static vector<pair<string, int>> topKmersHeap(const KmerTable& kmers, int n);
+    static vector<pair<string, int>> topKmers(const vector<KmerTable>& partitions, int n);
+    static vector<pair<string, int>> topKmersHeap(const vector<KmerTable>& partitions, int n);
+
+    static const size_t DENSE_MEMORY_BUDGET = 256ULL * 1024 * 1024;
+    static bool useDense(size_t seqLen, int k, size_t memoryBudget = DENSE_MEMORY_BUDGET);
+    static DenseKmerCounts countDense(const string& seq, int k, bool canonical = false);
+    static DenseKmerCounts countDense(const PackedSequence& seq, const vector<RecordRange>& ranges, int k,
+        bool canonical = false);
+    static vector<pair<string, int>> topKmers(const DenseKmerCounts& kmers, int n);
+
+    static vector<HeavyHitter> topKmersBounded(const PackedSequence& seq, const vector<RecordRange>& ranges, int k,
+        int n, size_t memoryBudget, bool exactPass = false, bool canonical = false);
 };
\ No newline at end of file
@@ -1,36 +1,48 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <cstdint>
 
 using namespace std;
 
-struct KmerNode {
-    string kmer;
-    int count;
-    KmerNode* left;
-    KmerNode* right;
-
-    KmerNode(const string& k, int c)
-        : kmer(k), count(c), left(nullptr), right(nullptr) {
-    }
-};
+class KmerTable;
+class DenseKmerCounts;
 
+// Static ordered k-mer index, bulk-built from 2-bit keys. Point lookups walk an
+// implicit Eytzinger (BFS-order) tree; range and prefix queries use the sorted
+// order and a prefix sum of counts.
 class KmerBST {
 private:
-    KmerNode* root;
+    vector<uint64_t> eytzinger;     // 1-based, eytzinger[0] unused
+    vector<uint32_t> eytzingerRank;
+    vector<uint64_t> sortedKeys;
+    vector<uint32_t> sortedCounts;
+    vector<uint64_t> countPrefix;   // countPrefix[i] = sum of sortedCounts[0..i)
+    int k;
 
-    KmerNode* insert(KmerNode* node, const string& kmer, int count);
-    void clear(KmerNode* node);
-    void inOrderTraversal(KmerNode* node, vector<pair<string, int>>& result) const;
-    KmerNode* findKmer(KmerNode* node, const string& kmer) const;
+    size_t fillEytzinger(size_t node, size_t rank);
+    size_t lowerBound(uint64_t key) const;
+    bool prefixRanks(const string& prefix, size_t& first, size_t& last) const;
+    vector<pair<string, int>> decodeRange(size_t first, size_t last) const;
 
 public:
     KmerBST();
-    ~KmerBST();
 
-    void insert(const string& kmer, int count);
+    void build(vector<pair<uint64_t, uint32_t>> entries, int k);
+    void build(const KmerTable& table);
+    void build(const vector<KmerTable>& partitions);
+    void build(const DenseKmerCounts& counts);
+
     bool contains(const string& kmer) const;
     int getCount(const string& kmer) const;
     vector<pair<string, int>> getAllKmers() const;
+
+    vector<pair<string, int>> getKmersWithPrefix(const string& prefix) const;
+    uint64_t countWithPrefix(const string& prefix) const;
+    vector<pair<string, int>> getKmersInRange(const string& low, const string& high) const;
+    uint64_t countInRange(const string& low, const string& high) const;
+
+    size_t size() const { return sortedKeys.size(); }
+    int getK() const { return k; }
     void clear();
 };
\ No newline at end of file
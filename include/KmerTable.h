@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Open-addressing (linear probing) counter keyed by 2-bit encoded k-mers, k <= 32.
+class KmerTable {
+private:
+    struct Slot {
+        uint64_t key;
+        uint32_t count;
+    };
+
+    vector<Slot> slots;
+    size_t used;
+    size_t mask;
+    int k;
+
+    void grow();
+
+    static uint64_t hashKey(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+public:
+    static constexpr int MAX_K = 32;
+
+    explicit KmerTable(int k = 0, size_t expected = 0);
+
+    void add(uint64_t key, uint32_t amount = 1) {
+        size_t i = hashKey(key) & mask;
+        while (slots[i].count != 0) {
+            if (slots[i].key == key) {
+                slots[i].count += amount;
+                return;
+            }
+            i = (i + 1) & mask;
+        }
+        slots[i].key = key;
+        slots[i].count = amount;
+        if (++used * 10 > slots.size() * 7) grow();
+    }
+
+    bool increment(uint64_t key) {
+        size_t i = hashKey(key) & mask;
+        while (slots[i].count != 0) {
+            if (slots[i].key == key) {
+                slots[i].count++;
+                return true;
+            }
+            i = (i + 1) & mask;
+        }
+        return false;
+    }
+
+    uint32_t get(uint64_t key) const;
+    void clear();
+
+    int getK() const { return k; }
+    size_t size() const { return used; }
+    bool empty() const { return used == 0; }
+    size_t memoryUsage() const { return slots.capacity() * sizeof(Slot); }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const Slot& slot : slots) {
+            if (slot.count != 0) fn(slot.key, slot.count);
+        }
+    }
+
+    static uint64_t hash(uint64_t key) { return hashKey(key); }
+    static string decode(uint64_t key, int k);
+    static bool encode(const string& kmer, uint64_t& key);
+};
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+using namespace std;
+
+class MappedFile {
+private:
+    const char* data;
+    size_t length;
+    bool opened;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const string& filename);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char* getData() const { return data; }
+    size_t size() const { return length; }
+};
\ No newline at end of file
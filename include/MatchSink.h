@@ -0,0 +1,138 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <fstream>
+
+using namespace std;
+
+struct FastaRecord;
+
+// Receives match start positions as a search produces them, in text order.
+// Returning false from onMatch stops the search.
+//
+// Parallel searches scan chunks out of order and use the hints below to avoid
+// buffering what the sink will not look at: a chunk keeps at most
+// positionsWanted() positions, then either stops or, if countsRest(), only
+// counts further hits and passes the total to onCount.
+class MatchSink {
+public:
+    virtual ~MatchSink() = default;
+    virtual bool onMatch(size_t pos) = 0;
+    virtual size_t positionsWanted() const { return SIZE_MAX; }
+    virtual bool countsRest() const { return false; }
+    virtual bool onCount(size_t) { return true; }
+};
+
+class VectorSink : public MatchSink {
+private:
+    vector<size_t>& out;
+
+public:
+    explicit VectorSink(vector<size_t>& target) : out(target) {}
+    bool onMatch(size_t pos) override {
+        out.push_back(pos);
+        return true;
+    }
+};
+
+class CountSink : public MatchSink {
+public:
+    size_t count = 0;
+
+    bool onMatch(size_t) override {
+        count++;
+        return true;
+    }
+    size_t positionsWanted() const override { return 0; }
+    bool countsRest() const override { return true; }
+    bool onCount(size_t n) override {
+        count += n;
+        return true;
+    }
+};
+
+// Existence check: stops at the first hit.
+class FirstMatchSink : public MatchSink {
+public:
+    bool found = false;
+    size_t position = 0;
+
+    bool onMatch(size_t pos) override {
+        found = true;
+        position = pos;
+        return false;
+    }
+    size_t positionsWanted() const override { return found ? 0 : 1; }
+};
+
+// Keeps the first `limit` positions. With countAll the search continues and
+// only the total is tracked past the limit; otherwise it stops there.
+class FirstNSink : public MatchSink {
+private:
+    size_t limit;
+    bool countAll;
+
+public:
+    vector<size_t> positions;
+    size_t count = 0;
+
+    explicit FirstNSink(size_t n, bool countRest = false) : limit(n), countAll(countRest) {
+        positions.reserve(n);
+    }
+    bool onMatch(size_t pos) override {
+        if (positions.size() < limit) positions.push_back(pos);
+        count++;
+        return countAll || count < limit;
+    }
+    size_t positionsWanted() const override { return count < limit ? limit - count : 0; }
+    bool countsRest() const override { return countAll; }
+    bool onCount(size_t n) override {
+        count += n;
+        return true;
+    }
+};
+
+// Buffered text output shared by several sinks writing to one file.
+class BufferedWriter {
+private:
+    ofstream out;
+    string buffer;
+    size_t threshold;
+
+public:
+    explicit BufferedWriter(const string& path, size_t bufferBytes = 1 << 20);
+    ~BufferedWriter();
+
+    bool isOpen() const { return out.is_open(); }
+    void append(const char* data, size_t length);
+    void append(const string& text) { append(text.data(), text.size()); }
+    void append(size_t value);
+    void append(double value, int precision);
+    void append(char c);
+    void flush();
+
+    // Fixed-point formatting for callers that build text before writing it.
+    static void appendFixed(string& out, double value, int precision);
+};
+
+// Writes each match as a BED6 line in record coordinates. Positions are
+// relative to storeOffset in the loaded store; since matches arrive in order,
+// the current record is advanced instead of looked up per hit.
+class BedSink : public MatchSink {
+private:
+    BufferedWriter& writer;
+    const vector<FastaRecord>& records;
+    size_t storeOffset;
+    size_t length;
+    string name;
+    char strand;
+    size_t record;
+
+public:
+    size_t count = 0;
+
+    BedSink(BufferedWriter& out, const vector<FastaRecord>& fastaRecords, size_t offset,
+        size_t matchLength, const string& featureName, char featureStrand = '+');
+    bool onMatch(size_t pos) override;
+};
\ No newline at end of file
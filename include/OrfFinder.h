@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class PackedSequence;
+class BufferedWriter;
+struct FastaRecord;
+struct RecordRange;
+
+struct OrfParams {
+    vector<string> startCodons = { "ATG" };
+    vector<string> stopCodons = { "TAA", "TAG", "TGA" };
+    size_t minLength = 300;     // nucleotides, stop codon included
+};
+
+struct Orf {
+    size_t record;      // index into the records the ranges came from
+    size_t start;       // relative to the scanned sequence; covers the stop codon
+    size_t end;
+    int frame;          // +1..+3 from the range start, -1..-3 from the range end
+
+    char strand() const { return frame > 0 ? '+' : '-'; }
+};
+
+// Six-frame ORF finder: for each stop codon, the longest in-frame stretch from
+// a start codon. Codons are matched 32 positions at a time by comparing the
+// 2-bit lanes of a word and its 1- and 2-base shifts, which yields start and
+// stop bitmaps for all three frames of both strands at once; the minus strand
+// uses the complemented codons read backwards, so nothing is copied. A codon
+// with an N breaks the frame. Chunk starts keep the frame phase, so threads
+// can take chunks independently; each remembers what every frame read before
+// its first stop, which completes ORFs carried in from the previous chunk.
+class OrfFinder {
+public:
+    enum Format { BED, GFF };
+
+    // Comma-separated list of 3-letter ACGT codons.
+    static bool parseCodons(const string& list, vector<string>& out);
+
+    // Sorted by start. Returns nothing if a codon in params is not 3 ACGT bases.
+    static vector<Orf> find(const PackedSequence& seq, const vector<RecordRange>& ranges,
+        const OrfParams& params = OrfParams(), unsigned threadCount = 1);
+
+    static void write(const vector<Orf>& orfs, const vector<FastaRecord>& records,
+        size_t storeOffset, Format format, BufferedWriter& out);
+};
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+using namespace std;
+
+struct NRun {
+    size_t start;
+    size_t length;
+};
+
+// Stores A/C/G/T at 2 bits per base (A=0, C=1, G=2, T=3), 32 bases per word.
+// N bases are kept out of band as a sorted run-length list; their 2-bit slot holds A.
+class PackedSequence {
+private:
+    vector<uint64_t> words;
+    vector<uint64_t> nBlocks;   // one bit per word, set if the word overlaps an N run
+    vector<NRun> nRuns;
+    size_t length;
+
+    void markNBlocks(size_t start, size_t len);
+    void clearCodes(size_t start, size_t len);
+    bool isNSlow(size_t pos) const;
+
+public:
+    static constexpr size_t BASES_PER_WORD = 32;
+
+    PackedSequence();
+    explicit PackedSequence(const string& seq);
+
+    void clear();
+    void reserve(size_t bases);
+    void push_back(char base);
+    void appendCode(uint8_t code);
+    void appendN(size_t count);
+    void append(const string& bases);
+    void append(const PackedSequence& other);
+
+    // Bulk fill for loaders that pack chunks concurrently: assign() sizes the
+    // sequence to `bases` A slots, threads OR codes into disjoint words through
+    // wordData(), and N runs are then added in position order with markN.
+    void assign(size_t bases);
+    uint64_t* wordData() { return words.data(); }
+    void markN(size_t start, size_t count);
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    char operator[](size_t pos) const {
+        static const char BASES[4] = { 'A', 'C', 'G', 'T' };
+        if ((nBlocks[pos >> 11] >> ((pos >> 5) & 63)) & 1) {
+            if (isNSlow(pos)) return 'N';
+        }
+        return BASES[code(pos)];
+    }
+
+    uint8_t code(size_t pos) const {
+        return static_cast<uint8_t>((words[pos >> 5] >> ((pos & 31) * 2)) & 3);
+    }
+
+    bool isN(size_t pos) const {
+        return ((nBlocks[pos >> 11] >> ((pos >> 5) & 63)) & 1) && isNSlow(pos);
+    }
+
+    bool wordHasN(size_t wordIndex) const {
+        return (nBlocks[wordIndex >> 6] >> (wordIndex & 63)) & 1;
+    }
+
+    size_t wordCount() const { return words.size(); }
+    uint64_t word(size_t wordIndex) const { return words[wordIndex]; }
+    uint64_t wordAt(size_t pos) const;
+
+    const vector<NRun>& getNRuns() const { return nRuns; }
+    size_t countN() const;
+    bool rangeHasN(size_t pos, size_t len) const;
+
+    // Calls fn(pos, symbol) over [begin, end), symbol 0-3 for A/C/G/T and 4 for N.
+    // If fn returns bool, returning false stops the walk.
+    template <typename Fn>
+    void forEachSymbol(size_t begin, size_t end, Fn&& fn) const {
+        auto call = [&fn](size_t pos, int symbol) -> bool {
+            if constexpr (is_same_v<invoke_result_t<Fn&, size_t, int>, bool>) {
+                return fn(pos, symbol);
+            }
+            else {
+                fn(pos, symbol);
+                return true;
+            }
+        };
+        auto run = lower_bound(nRuns.begin(), nRuns.end(), begin,
+            [](const NRun& r, size_t p) { return r.start + r.length <= p; });
+
+        size_t pos = begin;
+        while (pos < end) {
+            size_t w = pos >> 5;
+            uint64_t bits = words[w] >> ((pos & 31) * 2);
+            size_t wordEnd = min(end, (w + 1) * BASES_PER_WORD);
+            bool hasN = wordHasN(w);
+            for (; pos < wordEnd; pos++, bits >>= 2) {
+                if (hasN) {
+                    while (run != nRuns.end() && run->start + run->length <= pos) ++run;
+                    if (run != nRuns.end() && run->start <= pos) {
+                        if (!call(pos, 4)) return;
+                        continue;
+                    }
+                }
+                if (!call(pos, static_cast<int>(bits & 3))) return;
+            }
+        }
+    }
+
+    void reverseComplement();
+    PackedSequence slice(size_t pos, size_t len) const;
+    void decode(size_t pos, size_t len, char* out) const;
+    string toString() const;
+    string toString(size_t pos, size_t len) const;
+
+    size_t memoryUsage() const;
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Pool of worker threads pulling job indices from a shared counter, so
+// uneven jobs balance out. With one thread (or one job) everything runs on
+// the calling thread.
+class ParallelJobs {
+public:
+    // Calls job(i) once for every i in [first, last) on up to threadCount
+    // threads; 0 means one per hardware thread. Returns when all are done.
+    template <typename Job>
+    static void run(size_t first, size_t last, unsigned threadCount, Job&& job) {
+        if (first >= last) return;
+        if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+
+        atomic<size_t> next(first);
+        auto worker = [&]() {
+            for (size_t i = next++; i < last; i = next++) job(i);
+        };
+        unsigned workerCount = static_cast<unsigned>(min<size_t>(threadCount, last - first));
+        if (workerCount <= 1) {
+            worker();
+            return;
+        }
+        vector<thread> workers;
+        for (unsigned t = 0; t < workerCount; t++) workers.emplace_back(worker);
+        for (auto& w : workers) w.join();
+    }
+};
\ No newline at end of file
@@ -1,14 +1,82 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <cstdint>
 
 using namespace std;
 
+class PackedSequence;
+class SuffixArrayIndex;
+class FMIndex;
+class MatchSink;
+struct RecordRange;
+
+struct StrandedMatch {
+    size_t position;    // leftmost base of the hit on the forward strand
+    char strand;        // '+' or '-'
+};
+
 class PatternSearch {
 public:
-    static vector<int> kmp(const string& text, const string& pat);
-    static vector<int> boyerMoore(const string& text, const string& pat);
-    static vector<int> rabinKarp(const string& text, const string& pat);
-    static vector<int> naiveSearch(const string& text, const string& pat);
+    // Order matches getAlgorithmNames().
+    enum Algorithm {
+        KMP, BOYER_MOORE, HORSPOOL, BM_GOOD_SUFFIX, QGRAM_BM,
+        RABIN_KARP, NAIVE, SIMD, IUPAC,
+        APPROX_HAMMING, APPROX_EDIT,
+        SUFFIX_ARRAY, FM_INDEX,
+        ALGORITHM_COUNT
+    };
+
+    enum Strand { PLUS_STRAND, MINUS_STRAND, BOTH_STRANDS };
+
+    static vector<size_t> kmp(const string& text, const string& pat);
+    static vector<size_t> boyerMoore(const string& text, const string& pat);
+    static vector<size_t> rabinKarp(const string& text, const string& pat);
+    static vector<size_t> naiveSearch(const string& text, const string& pat);
+    static vector<size_t> kmp(const PackedSequence& text, const string& pat);
+    static vector<size_t> boyerMoore(const PackedSequence& text, const string& pat);
+    static vector<size_t> rabinKarp(const PackedSequence& text, const string& pat);
+    static vector<size_t> naiveSearch(const PackedSequence& text, const string& pat);
+    static vector<size_t> simdSearch(const string& text, const string& pat);
+    static vector<size_t> simdSearch(const PackedSequence& text, const string& pat);
+    static vector<size_t> iupacSearch(const string& text, const string& pat);
+    static vector<size_t> iupacSearch(const PackedSequence& text, const string& pat);
+    static bool isDegenerate(const string& pat);
+    static void iupacSearchStranded(const PackedSequence& text, const string& pat, Strand strand,
+        MatchSink& plusSink, MatchSink& minusSink);
+    static void simdSearchStranded(const PackedSequence& text, const string& pat, Strand strand,
+        MatchSink& plusSink, MatchSink& minusSink);
+    static vector<size_t> suffixArray(const SuffixArrayIndex& index, const PackedSequence& text, const string& pat);
+    static vector<uint64_t> fmIndex(const FMIndex& index, const string& pat);
+    static vector<size_t> run(Algorithm algorithm, const PackedSequence& text, const string& pat);
+    static vector<size_t> runParallel(Algorithm algorithm, const PackedSequence& text, const string& pat,
+        unsigned threadCount = 0);
+
+    // Streaming forms: positions go to the sink in text order instead of a
+    // vector. They return false if the sink stopped the search early.
+    static bool run(Algorithm algorithm, const PackedSequence& text, const string& pat, MatchSink& sink);
+    static bool run(Algorithm algorithm, const string& text, const string& pat, MatchSink& sink);
+    static bool runParallel(Algorithm algorithm, const PackedSequence& text, const string& pat,
+        MatchSink& sink, unsigned threadCount = 0);
+
+    // Record-aware forms: ranges are the records inside text (relative to it,
+    // sorted), and a match never spans the end of one and the start of the next.
+    static bool run(Algorithm algorithm, const PackedSequence& text, const vector<RecordRange>& ranges,
+        const string& pat, MatchSink& sink);
+    static bool runParallel(Algorithm algorithm, const PackedSequence& text, const vector<RecordRange>& ranges,
+        const string& pat, MatchSink& sink, unsigned threadCount = 0);
+
+    // Minus-strand hits are found by searching the reverse-complemented pattern
+    // against the forward text, so the genome is never copied. SIMD and IUPAC
+    // match both patterns in the same pass.
+    static vector<StrandedMatch> runStranded(Algorithm algorithm, const PackedSequence& text, const string& pat,
+        Strand strand, unsigned threadCount = 1);
+    static void runStranded(Algorithm algorithm, const PackedSequence& text, const string& pat,
+        Strand strand, MatchSink& plusSink, MatchSink& minusSink, unsigned threadCount = 1);
+    static void runStranded(Algorithm algorithm, const PackedSequence& text, const vector<RecordRange>& ranges,
+        const string& pat, Strand strand, MatchSink& plusSink, MatchSink& minusSink, unsigned threadCount = 1);
+    static vector<StrandedMatch> mergeStrands(const vector<size_t>& plus, const vector<size_t>& minus);
+    static bool isIndexed(Algorithm algorithm) { return algorithm == SUFFIX_ARRAY || algorithm == FM_INDEX; }
+    static bool isApproximate(Algorithm algorithm) { return algorithm == APPROX_HAMMING || algorithm == APPROX_EDIT; }
     static vector<string> getAlgorithmNames();
 };
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "PackedSequence.h"
+#include "SequenceLoader.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+struct ScreenStats {
+    size_t windows = 0;         // N-free windows fingerprinted
+    size_t candidates = 0;      // windows whose fingerprint matched a probe
+    size_t matches = 0;
+    size_t collisions = 0;      // candidates rejected by verification
+    size_t basesCompared = 0;   // verification cost
+};
+
+// Rolling polynomial fingerprints over 2-bit base codes modulo the Mersenne
+// prime 2^61-1. A set of equal-length probes is screened in one pass: each
+// window's fingerprint goes through a bit filter and then a hash lookup, and
+// only fingerprint hits are verified base by base.
+class RabinKarp {
+private:
+    vector<string> names;
+    vector<string> sequences;
+    vector<vector<uint8_t>> codes;
+    unordered_map<uint64_t, int32_t> firstProbe;    // fingerprint -> first probe
+    vector<int32_t> nextSame;                       // next probe with the same fingerprint, or -1
+    vector<uint64_t> filter;                        // one bit per fingerprint bucket
+    uint64_t filterMask;
+    uint64_t outgoing[4];                           // code * BASE^(length-1)
+    size_t length;
+
+    void rebuildFilter();
+
+public:
+    static constexpr uint64_t MODULUS = (1ULL << 61) - 1;
+    static constexpr uint64_t BASE = 0x1F3D5B79A2C4E687ULL % MODULUS;
+
+    static uint64_t mulMod(uint64_t a, uint64_t b) {
+#ifdef _MSC_VER
+        uint64_t hi;
+        uint64_t lo = _umul128(a, b, &hi);
+#else
+        unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+        uint64_t lo = static_cast<uint64_t>(product);
+        uint64_t hi = static_cast<uint64_t>(product >> 64);
+#endif
+        uint64_t folded = (lo & MODULUS) + (lo >> 61) + (hi << 3);
+        folded = (folded & MODULUS) + (folded >> 61);
+        return folded >= MODULUS ? folded - MODULUS : folded;
+    }
+    static uint64_t addMod(uint64_t a, uint64_t b) {
+        uint64_t sum = a + b;
+        return sum >= MODULUS ? sum - MODULUS : sum;
+    }
+    static uint64_t subMod(uint64_t a, uint64_t b) {
+        return a >= b ? a - b : a + MODULUS - b;
+    }
+    static uint64_t power(size_t exponent);
+
+    RabinKarp();
+
+    void clear();
+    // Fails if the probe has a non-ACGT base or differs in length from the first probe.
+    bool addProbe(const string& sequence, const string& name = "");
+
+    size_t probeCount() const { return sequences.size(); }
+    size_t probeLength() const { return length; }
+    const string& getName(size_t probe) const { return names[probe]; }
+    const string& getSequence(size_t probe) const { return sequences[probe]; }
+
+    // Calls onHit(startPosition, probeIndex) for every verified occurrence, in
+    // text order. Windows stay inside one of the ranges (the records in text).
+    template <typename Fn>
+    ScreenStats scan(const PackedSequence& text, const vector<RecordRange>& ranges, Fn&& onHit) const {
+        ScreenStats stats;
+        size_t m = length;
+        if (m == 0 || text.size() < m) return stats;
+
+        vector<uint8_t> window(m);      // ring of the last m codes
+        size_t slot = 0;
+        size_t run = 0;                 // N-free bases of the record ending at the current one
+        uint64_t hash = 0;
+        for (const RecordRange& range : ranges) {
+            run = 0;
+            hash = 0;
+            text.forEachSymbol(range.begin, range.end, [&](size_t pos, int symbol) {
+                if (symbol > 3) {
+                    run = 0;
+                    hash = 0;
+                    return;
+                }
+                if (run >= m) hash = subMod(hash, outgoing[window[slot]]);
+                hash = addMod(mulMod(hash, BASE), static_cast<uint64_t>(symbol));
+                window[slot] = static_cast<uint8_t>(symbol);
+                if (++slot == m) slot = 0;
+                if (++run < m) return;
+
+                stats.windows++;
+                if (!((filter[(hash & filterMask) >> 6] >> (hash & 63)) & 1)) return;
+                auto it = firstProbe.find(hash);
+                if (it == firstProbe.end()) return;
+
+                stats.candidates++;
+                bool any = false;
+                for (int32_t p = it->second; p >= 0; p = nextSame[p]) {
+                    const vector<uint8_t>& probe = codes[p];
+                    size_t j = 0;
+                    for (size_t s = slot; j < m && window[s] == probe[j]; j++) {
+                        if (++s == m) s = 0;
+                    }
+                    stats.basesCompared += j < m ? j + 1 : m;
+                    if (j == m) {
+                        any = true;
+                        stats.matches++;
+                        onHit(pos + 1 - m, static_cast<size_t>(p));
+                    }
+                }
+                if (!any) stats.collisions++;
+            });
+        }
+        return stats;
+    }
+
+    vector<size_t> countMatches(const PackedSequence& text, const vector<RecordRange>& ranges,
+        ScreenStats& stats) const;
+};
\ No newline at end of file
@@ -1,9 +1,74 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
 
 using namespace std;
 
+class PackedSequence;
+
+struct FastaRecord {
+    string name;
+    string header;
+    size_t offset;   // first base of the record within the loaded store
+    size_t start;    // coordinate of that base within the original record
+    size_t length;
+    size_t invalidChars = 0;    // input characters the loader replaced with N
+};
+
+// Part of one record inside a stretch of the store, in coordinates relative
+// to the start of that stretch.
+struct RecordRange {
+    size_t record;
+    size_t begin;
+    size_t end;
+};
+
+struct FaiEntry {
+    string name;
+    size_t length;
+    uint64_t offset;
+    size_t lineBases;
+    size_t lineWidth;
+};
+
 class SequenceLoader {
 public:
-    static bool loadFASTA(const string& filename, string& outSeq, string& outHeader);
+    static bool loadFASTAMapped(const string& filename, PackedSequence& outSeq,
+        vector<FastaRecord>& outRecords, unsigned threadCount = 0);
+
+    static bool loadIndex(const string& filename, vector<FaiEntry>& outIndex);
+    static bool buildIndex(const string& filename, vector<FaiEntry>& outIndex);
+    static bool readIndex(const string& faiPath, vector<FaiEntry>& outIndex);
+    static bool writeIndex(const string& faiPath, const vector<FaiEntry>& index);
+    static bool fetchRegion(const string& filename, const string& region,
+        PackedSequence& outSeq, vector<FastaRecord>& outRecords);
+
+    // name, name:start or name:start-end (1-based, inclusive); names are the
+    // known records, tried against the whole string before splitting on ':'.
+    static bool parseRegion(const string& region, const vector<string>& names, string& name,
+        size_t& start, size_t& end);
+    static bool resolveRegion(const vector<FastaRecord>& records, const string& region,
+        size_t& storeStart, size_t& length);
+    static size_t findRecord(const vector<FastaRecord>& records, size_t storePos);
+    static vector<RecordRange> recordRanges(const vector<FastaRecord>& records, size_t storeStart,
+        size_t length);
+
+    // Calls fn(from, to) for each part of [begin, end) inside one of the
+    // sorted ranges that is at least minLength long, so a scan over it never
+    // joins two records. fn returns false to stop.
+    template <typename Fn>
+    static void forEachRangePart(const vector<RecordRange>& ranges, size_t begin, size_t end,
+        size_t minLength, Fn&& fn)
+    {
+        auto it = lower_bound(ranges.begin(), ranges.end(), begin,
+            [](const RecordRange& range, size_t pos) { return range.end <= pos; });
+        for (; it != ranges.end() && it->begin < end; ++it) {
+            size_t from = max(it->begin, begin);
+            size_t to = min(it->end, end);
+            if (to - from < minLength) continue;
+            if (!fn(from, to)) return;
+        }
+    }
 };
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class PackedSequence;
+
+// Composition summary gathered in one pass over the packed words: base counts
+// by popcount on the 2-bit planes, N runs from the run list, and the same
+// polynomial hash as DNAUtils::sequenceHash, folded 32 bases at a time.
+struct SequenceStats {
+    size_t length = 0;
+    size_t counts[5] = {};      // A, C, G, T, N
+    size_t nRunCount = 0;
+    size_t longestNRun = 0;
+    size_t hash = 0;
+    size_t invalidChars = 0;    // replaced with N by the loader; compute() leaves it to the caller
+
+    double percent(int symbol) const {
+        return length == 0 ? 0.0 : counts[symbol] * 100.0 / length;
+    }
+    double gcPercent() const {
+        return length == 0 ? 0.0 : (counts[1] + counts[2]) * 100.0 / length;
+    }
+
+    // Chunks are hashed independently and combined as h(L) * 31^|R| + h(R).
+    static SequenceStats compute(const PackedSequence& seq, unsigned threadCount = 1);
+};
\ No newline at end of file
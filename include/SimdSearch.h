@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class MatchSink;
+
+// Exact-match kernel that compares the first and last pattern bytes at
+// 32 (AVX2) or 16 (SSE2) text positions per step and verifies only the
+// candidates. The widest backend the CPU supports is picked at runtime.
+class SimdSearch {
+public:
+    enum Backend { SCALAR, SSE2, AVX2 };
+
+    static Backend detect();
+    static Backend active();
+    static const char* backendName(Backend backend);
+
+    // Reports offset + i to the sink for every match starting at text[i];
+    // false if the sink stopped the search.
+    static bool find(const char* text, size_t length, const string& pat, size_t offset,
+        MatchSink& sink, Backend backend);
+    static bool find(const char* text, size_t length, const string& pat, size_t offset,
+        MatchSink& sink) {
+        return find(text, length, pat, offset, sink, active());
+    }
+
+    // One pass for both strands: hits of pat go to plusSink and hits of its
+    // reverse complement rc (same length) to minusSink; a null sink skips that
+    // strand, and a sink that stops is set to null so later chunks skip it.
+    // False once every requested sink has stopped.
+    static bool findStrands(const char* text, size_t length, const string& pat, const string& rc,
+        size_t offset, MatchSink*& plusSink, MatchSink*& minusSink, Backend backend);
+    static bool findStrands(const char* text, size_t length, const string& pat, const string& rc,
+        size_t offset, MatchSink*& plusSink, MatchSink*& minusSink) {
+        return findStrands(text, length, pat, rc, offset, plusSink, minusSink, active());
+    }
+
+    // Appends offset + i for every match starting at text[i].
+    static void find(const char* text, size_t length, const string& pat, size_t offset,
+        vector<size_t>& out, Backend backend);
+    static void find(const char* text, size_t length, const string& pat, size_t offset,
+        vector<size_t>& out) {
+        find(text, length, pat, offset, out, active());
+    }
+};
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "MappedFile.h"
+
+using namespace std;
+
+class PackedSequence;
+
+// Suffix array (SA-IS construction) plus Kasai LCP array over a loaded
+// PackedSequence. The index does not own the text; it must be queried with
+// the sequence it was built from. Supports at most 2^32 - 2 bases.
+class SuffixArrayIndex {
+private:
+    vector<uint32_t> saData;
+    vector<uint32_t> lcpData;
+    MappedFile mapped;
+    const uint32_t* sa;
+    const uint32_t* lcp;
+    size_t length;
+    uint64_t textHash;
+
+    int compareSuffix(const PackedSequence& text, uint32_t pos, const string& pat, size_t skip,
+        size_t& matched) const;
+
+public:
+    SuffixArrayIndex();
+
+    SuffixArrayIndex(const SuffixArrayIndex&) = delete;
+    SuffixArrayIndex& operator=(const SuffixArrayIndex&) = delete;
+
+    bool build(const PackedSequence& text, bool withLcp = true);
+    bool save(const string& filename) const;
+    bool load(const string& filename);
+    void clear();
+
+    bool isBuilt() const { return sa != nullptr; }
+    bool hasLcp() const { return lcp != nullptr; }
+    bool matches(const PackedSequence& text) const;
+    size_t size() const { return length; }
+    uint32_t suffixAt(size_t rank) const { return sa[rank]; }
+    size_t memoryUsage() const;
+
+    pair<size_t, size_t> findRange(const PackedSequence& text, const string& pat) const;
+    size_t count(const PackedSequence& text, const string& pat) const;
+    vector<size_t> locate(const PackedSequence& text, const string& pat) const;
+    size_t longestRepeat(size_t& position) const;
+
+    static uint64_t fingerprint(const PackedSequence& text);
+};
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "SequenceLoader.h"
+
+using namespace std;
+
+class PackedSequence;
+class BufferedWriter;
+
+struct TandemRepeatParams {
+    unsigned minPeriod = 1;
+    unsigned maxPeriod = 6;     // up to MAX_PERIOD
+    double minCopies = 3.0;
+    int minScore = 30;          // +2 per matching base, -7 per mismatch
+};
+
+struct TandemRepeat {
+    size_t record;      // index into the records the ranges came from
+    size_t start;       // relative to the scanned sequence
+    size_t end;
+    unsigned period;
+    int score;
+    size_t matches;     // bases equal to the base one period later
+    uint64_t unit;      // first period bases, 2 bits each, first base lowest
+
+    size_t length() const { return end - start; }
+    double copies() const { return static_cast<double>(length()) / period; }
+    double purity() const {
+        size_t compared = length() - period;
+        return compared == 0 ? 100.0 : matches * 100.0 / compared;
+    }
+    string unitString() const;
+};
+
+// Perfect and near-perfect tandem repeats found by comparing the sequence with
+// itself shifted by each period. Equality of a packed word and the word one
+// period later gives 32 comparisons at once; runs of 8 equal comparisons are
+// found with shift-and doubling and seed an X-drop extension scored +2/-7.
+// Repeats whose unit is itself periodic are left to the shorter period.
+//
+// Each nextBatch call scans the next few chunks on worker threads, drops the
+// copy of any repeat found from both sides of a chunk edge, and returns the
+// rest in sequence order, so output can be written while the rest of the
+// genome is still pending.
+class TandemRepeats {
+private:
+    struct Job {
+        size_t range;
+        size_t begin;
+        size_t end;
+    };
+
+    const PackedSequence& seq;
+    vector<RecordRange> ranges;
+    TandemRepeatParams params;
+    unsigned threadCount;
+    vector<Job> jobs;
+    size_t nextJob;
+    size_t lastRange;
+    vector<size_t> lastEnd;     // per period, end of the last repeat in lastRange
+
+    void scanJob(const Job& job, vector<TandemRepeat>& out) const;
+    void scanPeriod(const Job& job, unsigned period, vector<TandemRepeat>& out) const;
+
+public:
+    static constexpr unsigned MAX_PERIOD = 32;
+
+    TandemRepeats(const PackedSequence& sequence, const vector<RecordRange>& recordRanges,
+        const TandemRepeatParams& repeatParams = TandemRepeatParams(), unsigned threads = 1);
+
+    // Fills out with the next batch of repeats; false once the sequence is done.
+    bool nextBatch(vector<TandemRepeat>& out);
+
+    template <typename Fn>
+    size_t scan(Fn&& onRepeat) {
+        size_t total = 0;
+        vector<TandemRepeat> batch;
+        while (nextBatch(batch)) {
+            for (const TandemRepeat& repeat : batch) onRepeat(repeat);
+            total += batch.size();
+        }
+        return total;
+    }
+
+    // chrom, start, end, unit, period, copies, purity %, score
+    static void writeLine(const TandemRepeat& repeat, const vector<FastaRecord>& records,
+        size_t storeOffset, BufferedWriter& out);
+};
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "AhoCorasick.h"
+#include "DNAUtils.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static int baseCode(char c) {
+    switch (c) {
+    case 'A': case 'a': return 0;
+    case 'C': case 'c': return 1;
+    case 'G': case 'g': return 2;
+    case 'T': case 't': return 3;
+    default: return -1;
+    }
+}
+
+AhoCorasick::AhoCorasick() : built(false) {
+    newState();
+}
+
+int32_t AhoCorasick::newState() {
+    transitions.insert(transitions.end(), 4, -1);
+    fail.push_back(0);
+    terminal.push_back(-1);
+    outputLink.push_back(-1);
+    return static_cast<int32_t>(fail.size() - 1);
+}
+
+void AhoCorasick::clear() {
+    transitions.clear();
+    fail.clear();
+    terminal.clear();
+    outputLink.clear();
+    nextSame.clear();
+    motifs.clear();
+    built = false;
+    newState();
+}
+
+bool AhoCorasick::addPattern(const string& pattern, const string& name) {
+    if (pattern.empty()) return false;
+    for (char c : pattern) {
+        if (baseCode(c) < 0) return false;
+    }
+
+    Motif motif;
+    motif.pattern = pattern;
+    for (char& c : motif.pattern) c = static_cast<char>(toupper(c));
+    motif.name = name.empty() ? motif.pattern : name;
+    motifs.push_back(motif);
+    built = false;
+    return true;
+}
+
+void AhoCorasick::insert(const string& pattern, int32_t entry) {
+    int32_t state = 0;
+    for (char c : pattern) {
+        int code = baseCode(c);
+        if (transitions[state * 4 + code] < 0) {
+            int32_t next = newState();
+            transitions[state * 4 + code] = next;
+        }
+        state = transitions[state * 4 + code];
+    }
+
+    if (terminal[state] < 0) {
+        terminal[state] = entry;
+    }
+    else {
+        int32_t e = terminal[state];
+        while (nextSame[e] >= 0) e = nextSame[e];
+        nextSame[e] = entry;
+    }
+}
+
+// Inserts the requested strands of every motif into a fresh trie, then fills
+// missing transitions breadth-first from the failure state so the table
+// becomes a complete DFA.
+void AhoCorasick::build(bool plusStrand, bool minusStrand) {
+    transitions.clear();
+    fail.clear();
+    terminal.clear();
+    outputLink.clear();
+    newState();
+
+    nextSame.assign(2 * motifs.size(), -1);
+    for (size_t i = 0; i < motifs.size(); i++) {
+        if (plusStrand) insert(motifs[i].pattern, static_cast<int32_t>(i));
+        if (minusStrand) {
+            insert(DNAUtils::reverseComplement(motifs[i].pattern), static_cast<int32_t>(motifs.size() + i));
+        }
+    }
+
+    vector<int32_t> queue;
+    queue.reserve(fail.size());
+
+    for (int c = 0; c < 4; c++) {
+        int32_t child = transitions[c];
+        if (child < 0) {
+            transitions[c] = 0;
+        }
+        else {
+            fail[child] = 0;
+            queue.push_back(child);
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        int32_t state = queue[head];
+        int32_t f = fail[state];
+        outputLink[state] = terminal[f] >= 0 ? f : outputLink[f];
+
+        for (int c = 0; c < 4; c++) {
+            int32_t child = transitions[state * 4 + c];
+            if (child < 0) {
+                transitions[state * 4 + c] = transitions[f * 4 + c];
+            }
+            else {
+                fail[child] = transitions[f * 4 + c];
+                queue.push_back(child);
+            }
+        }
+    }
+    built = true;
+}
+
+size_t AhoCorasick::memoryUsage() const {
+    size_t bytes = (transitions.capacity() + fail.capacity() + terminal.capacity() +
+        outputLink.capacity() + nextSame.capacity()) * sizeof(int32_t);
+    for (const Motif& m : motifs) bytes += sizeof(Motif) + m.name.capacity() + m.pattern.capacity();
+    return bytes;
+}
+
+vector<size_t> AhoCorasick::countMatches(const PackedSequence& text, const vector<RecordRange>& ranges) const {
+    vector<size_t> counts(motifs.size(), 0);
+    scan(text, ranges, [&](size_t, size_t motif, char) { counts[motif]++; });
+    return counts;
+}
+
+// One motif per line: "SEQUENCE" or "NAME SEQUENCE"; a FASTA-style ">NAME"
+// line names the sequence that follows. Blank lines and '#' comments are ignored.
+// The caller builds the automaton for the strands it wants.
+bool AhoCorasick::loadMotifs(const string& filename, AhoCorasick& automaton, size_t& skipped) {
+    ifstream in(filename);
+    if (!in.is_open()) {
+        cerr << "Error: Could not open motif file: " << filename << '\n';
+        return false;
+    }
+
+    automaton.clear();
+    skipped = 0;
+    string line;
+    string pendingName;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        if (line[0] == '>') {
+            pendingName = line.substr(1);
+            continue;
+        }
+
+        istringstream fields(line);
+        string first, second;
+        fields >> first >> second;
+        if (first.empty()) continue;
+
+        string name = second.empty() ? pendingName : first;
+        string pattern = second.empty() ? first : second;
+        if (!automaton.addPattern(pattern, name)) skipped++;
+        pendingName.clear();
+    }
+    return automaton.patternCount() > 0;
+}
\ No newline at end of file
@@ -0,0 +1,281 @@
+#include "ApproximateSearch.h"
+#include "PackedSequence.h"
+#include "SequenceLoader.h"
+#include "ParallelJobs.h"
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+namespace {
+    // Text symbols: A=0, C=1, G=2, T=3, N=4.
+    const int SYMBOLS = 5;
+
+    int symbolOf(char c) {
+        switch (c) {
+        case 'A': case 'a': return 0;
+        case 'C': case 'c': return 1;
+        case 'G': case 'g': return 2;
+        case 'T': case 't': return 3;
+        case 'N': case 'n': return 4;
+        default: return -1;
+        }
+    }
+
+    struct RawHit {
+        size_t end;
+        int distance;
+        size_t floor;   // first base of the hit's record; its alignment starts no earlier
+    };
+
+    template <typename Fn>
+    void forEachSymbol(const string& text, size_t begin, size_t end, Fn&& fn) {
+        for (size_t i = begin; i < end; i++) {
+            int s = symbolOf(text[i]);
+            fn(i, s < 0 ? 4 : s);
+        }
+    }
+
+    template <typename Fn>
+    void forEachSymbol(const PackedSequence& text, size_t begin, size_t end, Fn&& fn) {
+        text.forEachSymbol(begin, end, fn);
+    }
+
+    // Per-symbol match masks, one bit per pattern position spread over `words` words.
+    vector<uint64_t> buildPeq(const string& pat, size_t words) {
+        vector<uint64_t> peq(SYMBOLS * words, 0);
+        for (size_t i = 0; i < pat.size(); i++) {
+            int s = symbolOf(pat[i]);
+            if (s >= 0) peq[s * words + (i >> 6)] |= 1ULL << (i & 63);
+        }
+        return peq;
+    }
+
+    // Shift-Or with k + 1 state vectors; a zero bit means "prefix matched".
+    template <typename Text>
+    void hammingScan(const Text& text, size_t begin, size_t end, size_t report, const string& pat,
+        int k, vector<RawHit>& hits)
+    {
+        size_t m = pat.size();
+        size_t words = (m + 63) / 64;
+        vector<uint64_t> peq = buildPeq(pat, words);
+        for (uint64_t& mask : peq) mask = ~mask;
+
+        vector<uint64_t> state((k + 1) * words, ~0ULL);
+        vector<uint64_t> below(words);
+        size_t lastWord = (m - 1) >> 6;
+        uint64_t lastBit = 1ULL << ((m - 1) & 63);
+
+        forEachSymbol(text, begin, end, [&](size_t pos, int symbol) {
+            const uint64_t* mask = &peq[symbol * words];
+            for (int j = 0; j <= k; j++) {
+                uint64_t* r = &state[j * words];
+                uint64_t carry = 0;
+                for (size_t w = 0; w < words; w++) {
+                    uint64_t shifted = (r[w] << 1) | carry;
+                    carry = r[w] >> 63;
+                    uint64_t next = shifted | mask[w];
+                    if (j > 0) next &= below[w];   // mismatch: advance from level j - 1
+                    below[w] = shifted;
+                    r[w] = next;
+                }
+            }
+            if (pos + 1 < begin + m || pos < report) return;
+            for (int j = 0; j <= k; j++) {
+                if (!(state[j * words + lastWord] & lastBit)) {
+                    hits.push_back({ pos, j });
+                    break;
+                }
+            }
+        });
+    }
+
+    // Myers' bit-vector algorithm in the block form (one block per 64 pattern
+    // bases); the score is tracked at the last pattern row.
+    template <typename Text>
+    void editScan(const Text& text, size_t begin, size_t end, size_t report, const string& pat,
+        int k, vector<RawHit>& hits)
+    {
+        size_t m = pat.size();
+        size_t blocks = (m + 63) / 64;
+        vector<uint64_t> peq = buildPeq(pat, blocks);
+        vector<uint64_t> pv(blocks, ~0ULL), mv(blocks, 0);
+        uint64_t lastHigh = 1ULL << ((m - 1) & 63);
+        int score = static_cast<int>(m);
+
+        forEachSymbol(text, begin, end, [&](size_t pos, int symbol) {
+            const uint64_t* eqs = &peq[symbol * blocks];
+            int hin = 0;
+            for (size_t b = 0; b < blocks; b++) {
+                uint64_t high = b + 1 == blocks ? lastHigh : 1ULL << 63;
+                uint64_t eq = eqs[b];
+                uint64_t xv = eq | mv[b];
+                if (hin < 0) eq |= 1;
+                uint64_t xh = (((eq & pv[b]) + pv[b]) ^ pv[b]) | eq;
+                uint64_t ph = mv[b] | ~(xh | pv[b]);
+                uint64_t mh = pv[b] & xh;
+
+                int hout = (ph & high) ? 1 : ((mh & high) ? -1 : 0);
+                ph <<= 1;
+                mh <<= 1;
+                if (hin < 0) mh |= 1;
+                else if (hin > 0) ph |= 1;
+                pv[b] = mh | ~(xv | ph);
+                mv[b] = ph & xv;
+                hin = hout;
+            }
+            score += hin;
+            if (score <= k && pos >= report) hits.push_back({ pos, score });
+        });
+    }
+
+    // Scans [begin, end) of the record starting at floor, keeping hits that end
+    // at or after report.
+    template <typename Text>
+    void scanPart(ApproximateSearch::Mode mode, const Text& text, size_t floor, size_t begin, size_t end,
+        size_t report, const string& pat, int k, vector<RawHit>& hits)
+    {
+        size_t first = hits.size();
+        if (mode == ApproximateSearch::HAMMING) hammingScan(text, begin, end, report, pat, k, hits);
+        else editScan(text, begin, end, report, pat, k, hits);
+        for (size_t i = first; i < hits.size(); i++) hits[i].floor = floor;
+    }
+
+    // Finds where the best alignment ending at `end` starts by aligning the
+    // reversed pattern against the text read backwards from `end`, no further
+    // back than floor.
+    template <typename Text>
+    size_t alignStart(const Text& text, const string& pat, size_t end, size_t floor, int k) {
+        size_t m = pat.size();
+        size_t window = min(end + 1 - floor, m + static_cast<size_t>(k));
+        vector<int> prev(window + 1), cur(window + 1);
+        for (size_t j = 0; j <= window; j++) prev[j] = static_cast<int>(j);
+
+        vector<int> textSymbols(window);
+        for (size_t j = 0; j < window; j++) {
+            int s = symbolOf(text[end - j]);
+            textSymbols[j] = s < 0 ? 4 : s;
+        }
+
+        for (size_t i = 1; i <= m; i++) {
+            int ps = symbolOf(pat[m - i]);
+            cur[0] = static_cast<int>(i);
+            for (size_t j = 1; j <= window; j++) {
+                int sub = prev[j - 1] + (ps >= 0 && ps == textSymbols[j - 1] ? 0 : 1);
+                cur[j] = min(sub, min(prev[j], cur[j - 1]) + 1);
+            }
+            swap(prev, cur);
+        }
+
+        size_t best = m <= window ? m : window;
+        for (size_t j = 1; j <= window; j++) {
+            if (prev[j] < prev[best] || (prev[j] == prev[best] && j < best)) best = j;
+        }
+        return end + 1 - best;
+    }
+
+    template <typename Text>
+    vector<ApproxMatch> finish(const Text& text, const string& pat, int k,
+        ApproximateSearch::Mode mode, const vector<RawHit>& hits)
+    {
+        vector<ApproxMatch> result;
+        if (mode == ApproximateSearch::HAMMING) {
+            result.reserve(hits.size());
+            for (const RawHit& hit : hits) {
+                result.push_back({ hit.end + 1 - pat.size(), hit.end, hit.distance });
+            }
+            return result;
+        }
+
+        // Consecutive end positions in one record belong to one occurrence; keep its best end.
+        for (size_t i = 0; i < hits.size(); ) {
+            size_t bestIndex = i;
+            size_t j = i + 1;
+            while (j < hits.size() && hits[j].end == hits[j - 1].end + 1 && hits[j].floor == hits[i].floor) {
+                if (hits[j].distance < hits[bestIndex].distance) bestIndex = j;
+                j++;
+            }
+            const RawHit& best = hits[bestIndex];
+            result.push_back({ alignStart(text, pat, best.end, best.floor, k), best.end, best.distance });
+            i = j;
+        }
+        return result;
+    }
+
+    template <typename Text>
+    vector<ApproxMatch> searchImpl(ApproximateSearch::Mode mode, const Text& text,
+        const vector<RecordRange>& ranges, const string& pat, int k)
+    {
+        if (pat.empty() || k < 0 || text.size() == 0) return {};
+        k = min(k, static_cast<int>(pat.size()));
+
+        vector<RawHit> hits;
+        for (const RecordRange& range : ranges) {
+            scanPart(mode, text, range.begin, range.begin, range.end, range.begin, pat, k, hits);
+        }
+        return finish(text, pat, k, mode, hits);
+    }
+
+    template <typename Text>
+    vector<ApproxMatch> searchImpl(ApproximateSearch::Mode mode, const Text& text, const string& pat, int k) {
+        return searchImpl(mode, text, vector<RecordRange>{ { 0, 0, text.size() } }, pat, k);
+    }
+}
+
+vector<ApproxMatch> ApproximateSearch::hamming(const string& text, const string& pat, int maxMismatches) {
+    return searchImpl(HAMMING, text, pat, maxMismatches);
+}
+
+vector<ApproxMatch> ApproximateSearch::hamming(const PackedSequence& text, const string& pat, int maxMismatches) {
+    return searchImpl(HAMMING, text, pat, maxMismatches);
+}
+
+vector<ApproxMatch> ApproximateSearch::edit(const string& text, const string& pat, int maxDistance) {
+    return searchImpl(EDIT, text, pat, maxDistance);
+}
+
+vector<ApproxMatch> ApproximateSearch::edit(const PackedSequence& text, const string& pat, int maxDistance) {
+    return searchImpl(EDIT, text, pat, maxDistance);
+}
+
+vector<ApproxMatch> ApproximateSearch::search(Mode mode, const PackedSequence& text,
+    const vector<RecordRange>& ranges, const string& pat, int maxDistance)
+{
+    return searchImpl(mode, text, ranges, pat, maxDistance);
+}
+
+// Same chunking as PatternSearch::runParallel, except each chunk owns the hits
+// that end inside it and scans a lead-in of m + k - 1 bases before it (within
+// the record), long enough to contain any alignment within the distance limit.
+vector<ApproxMatch> ApproximateSearch::searchParallel(Mode mode, const PackedSequence& text,
+    const vector<RecordRange>& ranges, const string& pat, int maxDistance, unsigned threadCount)
+{
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+
+    const size_t minChunk = 1 << 16;
+    threadCount = static_cast<unsigned>(min<size_t>(threadCount, text.size() / minChunk));
+    if (threadCount <= 1 || pat.empty() || maxDistance < 0) {
+        return search(mode, text, ranges, pat, maxDistance);
+    }
+    int k = min(maxDistance, static_cast<int>(pat.size()));
+    size_t leadIn = pat.size() + k - 1;
+
+    size_t chunkCount = static_cast<size_t>(threadCount) * 4;
+    size_t chunkLen = (text.size() + chunkCount - 1) / chunkCount;
+    vector<vector<RawHit>> chunkHits(chunkCount);
+    ParallelJobs::run(0, chunkCount, threadCount, [&](size_t c) {
+        size_t begin = c * chunkLen;
+        size_t end = min(text.size(), begin + chunkLen);
+        auto range = lower_bound(ranges.begin(), ranges.end(), begin,
+            [](const RecordRange& r, size_t pos) { return r.end <= pos; });
+        for (; range != ranges.end() && range->begin < end; ++range) {
+            size_t from = max(range->begin, begin);
+            size_t scanBegin = max(range->begin, from > leadIn ? from - leadIn : 0);
+            scanPart(mode, text, range->begin, scanBegin, min(range->end, end), from, pat, k, chunkHits[c]);
+        }
+    });
+
+    vector<RawHit> hits;
+    for (const auto& part : chunkHits) hits.insert(hits.end(), part.begin(), part.end());
+    return finish(text, pat, k, mode, hits);
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "CpGIslands.h"
+#include "PackedSequence.h"
+#include "SequenceLoader.h"
+#include "MatchSink.h"
+#include "ParallelJobs.h"
+#include <algorithm>
+
+using namespace std;
+
+static const size_t CHUNK_BASES = 1 << 22;
+static const int SYM_C = 1;
+static const int SYM_G = 2;
+static const int SYM_N = 4;
+
+struct ScanJob {
+    size_t record;
+    size_t begin;       // first window start
+    size_t end;         // last window start + 1
+    size_t limit;       // end of the record range
+};
+
+// Unions of qualifying windows that start in [job.begin, job.end).
+static void scanJob(const PackedSequence& seq, const ScanJob& job, const CpGIslandParams& params,
+    vector<CpGIsland>& out)
+{
+    const size_t w = params.window;
+    size_t readEnd = min(job.limit, job.end + w - 1);
+    if (readEnd < job.begin + w) return;
+
+    const double minGc = params.minGcPercent / 100.0 * w;
+    vector<uint8_t> ring(w);
+    size_t slot = 0;
+    size_t c = 0, g = 0, cpg = 0, n = 0;
+    int prev = SYM_N;
+    bool open = false;
+    CpGIsland current{ job.record, 0, 0 };
+
+    seq.forEachSymbol(job.begin, readEnd, [&](size_t pos, int symbol) {
+        if (pos >= job.begin + w) {
+            int leaving = ring[slot];
+            if (leaving == SYM_C) {
+                c--;
+                if (ring[slot + 1 == w ? 0 : slot + 1] == SYM_G) cpg--;
+            }
+            else if (leaving == SYM_G) g--;
+            else if (leaving == SYM_N) n--;
+        }
+        if (symbol == SYM_C) c++;
+        else if (symbol == SYM_G) {
+            g++;
+            if (prev == SYM_C) cpg++;
+        }
+        else if (symbol == SYM_N) n++;
+        ring[slot] = static_cast<uint8_t>(symbol);
+        if (++slot == w) slot = 0;
+        prev = symbol;
+
+        if (pos + 1 < job.begin + w) return;
+        size_t start = pos + 1 - w;
+        // Like CpGIsland::obsExp(), a window lacking C or G has no defined ratio.
+        if (n != 0 || c == 0 || g == 0 || c + g < minGc ||
+            static_cast<double>(cpg) * w < params.minObsExp * c * g) return;
+
+        if (open && start <= current.end) {
+            current.end = start + w;
+        }
+        else {
+            if (open) out.push_back(current);
+            current.start = start;
+            current.end = start + w;
+            open = true;
+        }
+    });
+    if (open) out.push_back(current);
+}
+
+static void measure(const PackedSequence& seq, CpGIsland& island) {
+    island.c = island.g = island.cpg = 0;
+    int prev = SYM_N;
+    seq.forEachSymbol(island.start, island.end, [&](size_t, int symbol) {
+        if (symbol == SYM_C) island.c++;
+        else if (symbol == SYM_G) {
+            island.g++;
+            if (prev == SYM_C) island.cpg++;
+        }
+        prev = symbol;
+    });
+}
+
+vector<CpGIsland> CpGIslands::find(const PackedSequence& seq, const vector<RecordRange>& ranges,
+    const CpGIslandParams& params, unsigned threadCount)
+{
+    vector<CpGIsland> islands;
+    if (params.window < 2) return islands;
+
+    vector<ScanJob> jobs;
+    for (const RecordRange& range : ranges) {
+        if (range.end - range.begin < params.window) continue;
+        size_t lastStart = range.end - params.window + 1;
+        for (size_t begin = range.begin; begin < lastStart; begin += CHUNK_BASES) {
+            jobs.push_back({ range.record, begin, min(lastStart, begin + CHUNK_BASES), range.end });
+        }
+    }
+
+    vector<vector<CpGIsland>> found(jobs.size());
+    ParallelJobs::run(0, jobs.size(), threadCount, [&](size_t j) {
+        scanJob(seq, jobs[j], params, found[j]);
+    });
+
+    // Jobs are in sequence order, so only the last island so far can touch the next one.
+    for (vector<CpGIsland>& part : found) {
+        for (const CpGIsland& island : part) {
+            if (!islands.empty() && islands.back().record == island.record &&
+                island.start <= islands.back().end) {
+                islands.back().end = max(islands.back().end, island.end);
+            }
+            else {
+                islands.push_back(island);
+            }
+        }
+        vector<CpGIsland>().swap(part);
+    }
+
+    size_t kept = 0;
+    for (CpGIsland& island : islands) {
+        if (island.length() < params.minLength) continue;
+        measure(seq, island);
+        if (island.gcPercent() < params.minGcPercent || island.obsExp() < params.minObsExp) continue;
+        islands[kept++] = island;
+    }
+    islands.resize(kept);
+    return islands;
+}
+
+void CpGIslands::writeBed(const vector<CpGIsland>& islands, const vector<FastaRecord>& records,
+    size_t storeOffset, BufferedWriter& out)
+{
+    for (const CpGIsland& island : islands) {
+        const FastaRecord& record = records[island.record];
+        size_t start = storeOffset + island.start - record.offset + record.start;
+        out.append(record.name);
+        out.append('\t');
+        out.append(start);
+        out.append('\t');
+        out.append(start + island.length());
+        out.append("\tCpG: ", 6);
+        out.append(island.cpg);
+        out.append('\t');
+        out.append(island.length());
+        out.append('\t');
+        out.append(island.cpg);
+        out.append('\t');
+        out.append(island.c + island.g);
+        out.append('\t');
+        out.append(island.cpg * 200.0 / island.length(), 1);
+        out.append('\t');
+        out.append(island.gcPercent(), 1);
+        out.append('\t');
+        out.append(island.obsExp(), 2);
+        out.append('\n');
+    }
+}
\ No newline at end of file
@@ -1,8 +1,11 @@
 #include "DNAUtils.h"
 #include "PatternSearch.h"
+#include "MatchSink.h"
 #include <algorithm>
 #include <iostream>
 #include <functional>
+#include <bit>
+#include <array>
 
 using namespace std;
 
@@ -19,28 +22,49 @@ double DNAUtils::gcContent(const string& seq) {
 
 bool DNAUtils::containsSRY(const string& seq) {
     string marker = "TCCAGTTTTGTTACAGGG";
-    auto found = PatternSearch::kmp(seq, marker);
-    return !found.empty();
+    FirstMatchSink first;
+    PatternSearch::run(PatternSearch::SIMD, seq, marker, first);
+    return first.found;
 }
 
-string DNAUtils::reverseComplement(const string& seq) {
-    string result;
-    result.reserve(seq.size());
-
-    for (auto it = seq.rbegin(); it != seq.rend(); ++it) {
-        switch (*it) {
-        case 'A': result += 'T'; break;
-        case 'T': result += 'A'; break;
-        case 'C': result += 'G'; break;
-        case 'G': result += 'C'; break;
-        case 'N': result += 'N'; break;
-        default:  result += 'N'; break;
-        }
+// IUPAC-aware complement table; case is preserved and unknown bytes become N.
+static const array<char, 256> COMPLEMENT_TABLE = []() {
+    array<char, 256> table;
+    table.fill('N');
+    const char* from = "ACGTURYKMBVDHSWN";
+    const char* to = "TGCAAYRMKVBHDSWN";
+    for (int i = 0; from[i]; i++) {
+        table[static_cast<unsigned char>(from[i])] = to[i];
+        table[static_cast<unsigned char>(tolower(from[i]))] = static_cast<char>(tolower(to[i]));
     }
+    return table;
+    }();
+
+char DNAUtils::complement(char base) {
+    return COMPLEMENT_TABLE[static_cast<unsigned char>(base)];
+}
 
+string DNAUtils::reverseComplement(const string& seq) {
+    string result(seq.size(), 'N');
+    size_t n = seq.size();
+    for (size_t i = 0; i < n; i++) {
+        result[n - 1 - i] = COMPLEMENT_TABLE[static_cast<unsigned char>(seq[i])];
+    }
     return result;
 }
 
+void DNAUtils::reverseComplementInPlace(string& seq) {
+    size_t i = 0, j = seq.size();
+    while (i + 1 < j) {
+        j--;
+        char left = COMPLEMENT_TABLE[static_cast<unsigned char>(seq[i])];
+        seq[i] = COMPLEMENT_TABLE[static_cast<unsigned char>(seq[j])];
+        seq[j] = left;
+        i++;
+    }
+    if (i + 1 == j) seq[i] = COMPLEMENT_TABLE[static_cast<unsigned char>(seq[i])];
+}
+
 bool DNAUtils::isValidDNA(const string& seq) {
     for (char c : seq) {
         if (c != 'A' && c != 'C' && c != 'G' && c != 'T' && c != 'N') {
@@ -82,4 +106,63 @@ size_t DNAUtils::sequenceHash(const string& seq) {
         hash = hash * prime + value;
     }
     return hash;
+}
+
+double DNAUtils::gcContent(const PackedSequence& seq) {
+    if (seq.empty()) return 0.0;
+
+    // C=01 and G=10 are the only codes whose two bits differ; N slots hold A.
+    const uint64_t lowBits = 0x5555555555555555ULL;
+    size_t gc = 0;
+    size_t fullWords = seq.size() / PackedSequence::BASES_PER_WORD;
+
+    for (size_t w = 0; w < fullWords; w++) {
+        uint64_t word = seq.word(w);
+        gc += popcount((word ^ (word >> 1)) & lowBits);
+    }
+
+    size_t tail = seq.size() % PackedSequence::BASES_PER_WORD;
+    if (tail > 0) {
+        uint64_t word = seq.word(fullWords);
+        uint64_t tailMask = (1ULL << (tail * 2)) - 1;
+        gc += popcount((word ^ (word >> 1)) & lowBits & tailMask);
+    }
+
+    return (gc * 100.0) / seq.size();
+}
+
+bool DNAUtils::containsSRY(const PackedSequence& seq, const vector<RecordRange>& ranges) {
+    string marker = "TCCAGTTTTGTTACAGGG";
+    FirstMatchSink first;
+    PatternSearch::run(PatternSearch::SIMD, seq, ranges, marker, first);
+    return first.found;
+}
+
+PackedSequence DNAUtils::reverseComplement(const PackedSequence& seq) {
+    PackedSequence result(seq);
+    result.reverseComplement();
+    return result;
+}
+
+void DNAUtils::reverseComplementInPlace(PackedSequence& seq) {
+    seq.reverseComplement();
+}
+
+bool DNAUtils::isValidDNA(const PackedSequence&) {
+    return true;
+}
+
+bool DNAUtils::quickValidation(const PackedSequence&) {
+    return true;
+}
+
+size_t DNAUtils::sequenceHash(const PackedSequence& seq) {
+    static const int VALUES[4] = { 1, 2, 3, 4 };
+    size_t hash = 0;
+    const size_t prime = 31;
+
+    for (size_t i = 0; i < seq.size(); i++) {
+        hash = hash * prime + (seq.isN(i) ? 5 : VALUES[seq.code(i)]);
+    }
+    return hash;
 }
\ No newline at end of file
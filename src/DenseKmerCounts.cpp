@@ -0,0 +1,56 @@
+#include "DenseKmerCounts.h"
+
+using namespace std;
+
+DenseKmerCounts::DenseKmerCounts() : k(0), width(0) {}
+
+DenseKmerCounts::DenseKmerCounts(int k, size_t maxCount) : k(k), width(counterWidth(maxCount)) {
+    size_t slots = size_t(1) << (2 * k);
+    switch (width) {
+    case 1: counts8.assign(slots, 0); break;
+    case 2: counts16.assign(slots, 0); break;
+    case 4: counts32.assign(slots, 0); break;
+    default: counts64.assign(slots, 0); break;
+    }
+}
+
+int DenseKmerCounts::counterWidth(size_t maxCount) {
+    if (maxCount <= UINT8_MAX) return 1;
+    if (maxCount <= UINT16_MAX) return 2;
+    if (maxCount <= UINT32_MAX) return 4;
+    return 8;
+}
+
+size_t DenseKmerCounts::requiredBytes(int k, size_t maxCount) {
+    if (k <= 0 || k > 30) return SIZE_MAX;
+    return (size_t(1) << (2 * k)) * counterWidth(maxCount);
+}
+
+uint64_t DenseKmerCounts::get(uint64_t code) const {
+    switch (width) {
+    case 1: return counts8[code];
+    case 2: return counts16[code];
+    case 4: return counts32[code];
+    default: return counts64[code];
+    }
+}
+
+size_t DenseKmerCounts::slotCount() const {
+    switch (width) {
+    case 1: return counts8.size();
+    case 2: return counts16.size();
+    case 4: return counts32.size();
+    case 8: return counts64.size();
+    default: return 0;
+    }
+}
+
+size_t DenseKmerCounts::distinct() const {
+    size_t total = 0;
+    forEach([&](uint64_t, uint64_t) { total++; });
+    return total;
+}
+
+size_t DenseKmerCounts::memoryUsage() const {
+    return slotCount() * width;
+}
\ No newline at end of file
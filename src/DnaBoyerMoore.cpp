@@ -0,0 +1,239 @@
+#include "DnaBoyerMoore.h"
+#include "MatchSink.h"
+#include "PackedSequence.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+static const array<uint8_t, 256> BASE_CODES = []() {
+    array<uint8_t, 256> codes;
+    codes.fill(4);
+    codes['A'] = 0; codes['C'] = 1; codes['G'] = 2; codes['T'] = 3;
+    return codes;
+    }();
+
+// shift[g] is how far the window may move when its last q bases form q-gram g
+// (first base in the low bits, as in PackedSequence words); 0 marks the
+// pattern's own final q-gram, after which matchShift applies.
+struct QgramTable {
+    unsigned q = 0;
+    size_t maxShift = 0;
+    size_t matchShift = 0;
+    vector<uint32_t> shift;
+};
+
+static bool buildQgramTable(const string& pat, unsigned q, QgramTable& table) {
+    size_t m = pat.size();
+    table.q = q;
+    table.maxShift = m - q + 1;
+    table.matchShift = table.maxShift;
+    table.shift.assign(size_t(1) << (2 * q), static_cast<uint32_t>(table.maxShift));
+
+    uint32_t finalCode = 0;
+    for (size_t i = 0; i + q <= m; i++) {
+        uint32_t code = 0;
+        for (unsigned k = 0; k < q; k++) {
+            uint8_t c = BASE_CODES[static_cast<unsigned char>(pat[i + k])];
+            if (c > 3) return false;
+            code |= static_cast<uint32_t>(c) << (2 * k);
+        }
+        table.shift[code] = static_cast<uint32_t>(m - q - i);
+        if (i + q == m) finalCode = code;
+    }
+
+    for (size_t i = 0; i + q < m; i++) {
+        uint32_t code = 0;
+        for (unsigned k = 0; k < q; k++) {
+            code |= static_cast<uint32_t>(BASE_CODES[static_cast<unsigned char>(pat[i + k])]) << (2 * k);
+        }
+        if (code == finalCode) table.matchShift = m - q - i;
+    }
+    return true;
+}
+
+unsigned DnaBoyerMoore::qgramLength(size_t patternLength) {
+    if (patternLength >= 16) return 4;
+    if (patternLength >= 8) return 3;
+    if (patternLength >= 3) return 2;
+    return 1;
+}
+
+bool DnaBoyerMoore::horspool(const char* text, size_t length, const string& pat, size_t offset,
+    MatchSink& sink)
+{
+    size_t m = pat.size();
+    if (m == 0 || length < m) return true;
+
+    size_t shift[256];
+    fill(begin(shift), end(shift), m);
+    for (size_t i = 0; i + 1 < m; i++) {
+        shift[static_cast<unsigned char>(pat[i])] = m - 1 - i;
+    }
+
+    const char last = pat[m - 1];
+    for (size_t pos = 0; pos + m <= length; ) {
+        char c = text[pos + m - 1];
+        if (c == last && memcmp(text + pos, pat.data(), m - 1) == 0) {
+            if (!sink.onMatch(offset + pos)) return false;
+        }
+        pos += shift[static_cast<unsigned char>(c)];
+    }
+    return true;
+}
+
+// Strong good-suffix table after Crochemore and Lecroq: gs[i] is the shift
+// after a mismatch at pat[i] with pat[i+1..] matched.
+static vector<size_t> buildGoodSuffix(const string& pat) {
+    ptrdiff_t m = static_cast<ptrdiff_t>(pat.size());
+    vector<ptrdiff_t> suff(m);
+    suff[m - 1] = m;
+    ptrdiff_t g = m - 1, f = m - 1;
+    for (ptrdiff_t i = m - 2; i >= 0; i--) {
+        if (i > g && suff[i + m - 1 - f] < i - g) {
+            suff[i] = suff[i + m - 1 - f];
+        }
+        else {
+            if (i < g) g = i;
+            f = i;
+            while (g >= 0 && pat[g] == pat[g + m - 1 - f]) g--;
+            suff[i] = f - g;
+        }
+    }
+
+    vector<size_t> gs(m, m);
+    ptrdiff_t j = 0;
+    for (ptrdiff_t i = m - 1; i >= 0; i--) {
+        if (suff[i] == i + 1) {
+            for (; j < m - 1 - i; j++) {
+                if (gs[j] == static_cast<size_t>(m)) gs[j] = m - 1 - i;
+            }
+        }
+    }
+    for (ptrdiff_t i = 0; i <= m - 2; i++) {
+        gs[m - 1 - suff[i]] = m - 1 - i;
+    }
+    return gs;
+}
+
+bool DnaBoyerMoore::goodSuffix(const char* text, size_t length, const string& pat, size_t offset,
+    MatchSink& sink)
+{
+    size_t m = pat.size();
+    if (m == 0 || length < m) return true;
+
+    ptrdiff_t badChar[256];
+    fill(begin(badChar), end(badChar), -1);
+    for (size_t i = 0; i < m; i++) {
+        badChar[static_cast<unsigned char>(pat[i])] = static_cast<ptrdiff_t>(i);
+    }
+    vector<size_t> gs = buildGoodSuffix(pat);
+
+    for (size_t pos = 0; pos + m <= length; ) {
+        ptrdiff_t i = static_cast<ptrdiff_t>(m) - 1;
+        while (i >= 0 && pat[i] == text[pos + i]) i--;
+
+        if (i < 0) {
+            if (!sink.onMatch(offset + pos)) return false;
+            pos += gs[0];
+        }
+        else {
+            ptrdiff_t bad = i - badChar[static_cast<unsigned char>(text[pos + i])];
+            pos += max<ptrdiff_t>(static_cast<ptrdiff_t>(gs[i]), bad);
+        }
+    }
+    return true;
+}
+
+bool DnaBoyerMoore::qgram(const char* text, size_t length, const string& pat, size_t offset,
+    MatchSink& sink)
+{
+    size_t m = pat.size();
+    if (m == 0 || length < m) return true;
+
+    QgramTable table;
+    if (!buildQgramTable(pat, qgramLength(m), table)) {
+        return horspool(text, length, pat, offset, sink);
+    }
+
+    const unsigned q = table.q;
+    for (size_t pos = 0; pos + m <= length; ) {
+        const char* gram = text + pos + m - q;
+        uint32_t code = 0;
+        uint8_t invalid = 0;
+        for (unsigned k = 0; k < q; k++) {
+            uint8_t c = BASE_CODES[static_cast<unsigned char>(gram[k])];
+            invalid |= c;
+            code |= static_cast<uint32_t>(c & 3) << (2 * k);
+        }
+        if (invalid & 4) {
+            pos += table.maxShift;
+            continue;
+        }
+
+        size_t shift = table.shift[code];
+        if (shift != 0) {
+            pos += shift;
+            continue;
+        }
+        if (memcmp(text + pos, pat.data(), m - q) == 0) {
+            if (!sink.onMatch(offset + pos)) return false;
+        }
+        pos += table.matchShift;
+    }
+    return true;
+}
+
+// N slots read as A, so a q-gram over an N run may look like a pattern q-gram;
+// that only shortens the shift, and rangeHasN rejects the candidate.
+bool DnaBoyerMoore::qgram(const PackedSequence& text, const string& pat, MatchSink& sink) {
+    return qgram(text, 0, text.size(), pat, sink);
+}
+
+bool DnaBoyerMoore::qgram(const PackedSequence& text, size_t begin, size_t end, const string& pat,
+    MatchSink& sink)
+{
+    size_t m = pat.size();
+    if (m == 0 || end < begin + m) return true;
+
+    QgramTable table;
+    if (!buildQgramTable(pat, qgramLength(m), table)) {
+        const size_t CHUNK = 1 << 16;
+        vector<char> buffer(CHUNK + m - 1);
+        for (size_t pos = begin; pos + m <= end; pos += CHUNK) {
+            size_t len = min(buffer.size(), end - pos);
+            text.decode(pos, len, buffer.data());
+            if (!horspool(buffer.data(), len, pat, pos - begin, sink)) return false;
+        }
+        return true;
+    }
+
+    PackedSequence packedPat(pat);
+    size_t patWords = packedPat.wordCount();
+    uint64_t tailMask = (m % PackedSequence::BASES_PER_WORD == 0) ? ~0ULL
+        : (1ULL << ((m % PackedSequence::BASES_PER_WORD) * 2)) - 1;
+    const unsigned q = table.q;
+    const uint64_t gramMask = (1ULL << (2 * q)) - 1;
+
+    for (size_t pos = begin; pos + m <= end; ) {
+        size_t shift = table.shift[text.wordAt(pos + m - q) & gramMask];
+        if (shift != 0) {
+            pos += shift;
+            continue;
+        }
+
+        bool match = true;
+        for (size_t w = 0; w < patWords && match; w++) {
+            uint64_t diff = text.wordAt(pos + w * PackedSequence::BASES_PER_WORD) ^ packedPat.word(w);
+            if (w + 1 == patWords) diff &= tailMask;
+            match = diff == 0;
+        }
+        if (match && !text.rangeHasN(pos, m)) {
+            if (!sink.onMatch(pos - begin)) return false;
+        }
+        pos += table.matchShift;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "FMIndex.h"
+#include "SuffixArrayIndex.h"
+#include "PackedSequence.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+    const char FM_MAGIC[8] = { 'D', 'N', 'A', 'F', 'M', 'I', 'X', '1' };
+    const int SYMBOL_N = 4;
+    const int SYMBOL_DOLLAR = 5;
+    const size_t RANK_FIELDS = 5;
+
+    size_t align8(size_t bytes) {
+        return (bytes + 7) & ~static_cast<size_t>(7);
+    }
+
+    // One bit per 2-bit slot (the low bit) set where the slot holds `code`.
+    uint64_t matchMask(uint64_t word, int code) {
+        uint64_t x = word ^ (0x5555555555555555ULL * static_cast<uint64_t>(code));
+        return ~(x | (x >> 1)) & 0x5555555555555555ULL;
+    }
+
+    int symbolOf(char c) {
+        switch (c) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        case 'N': return SYMBOL_N;
+        default: return -1;
+        }
+    }
+}
+
+FMIndex::FMIndex()
+    : header(nullptr), bwt(nullptr), special(nullptr), rankBlocks(nullptr),
+    sampled(nullptr), sampledRank(nullptr), samples(nullptr), rows(0), imageBytes(0), C{} {
+}
+
+size_t FMIndex::layout(size_t rows, size_t sampleCount, size_t offsets[7]) {
+    size_t bwtWords = (rows + 31) / 32;
+    size_t bitWords = (rows + 63) / 64;
+    size_t blocks = (rows + RANK_BLOCK - 1) / RANK_BLOCK + 1;
+
+    offsets[0] = 0;
+    offsets[1] = align8(sizeof(Header));
+    offsets[2] = offsets[1] + bwtWords * sizeof(uint64_t);
+    offsets[3] = offsets[2] + bitWords * sizeof(uint64_t);
+    offsets[4] = offsets[3] + align8(blocks * RANK_FIELDS * sizeof(uint32_t));
+    offsets[5] = offsets[4] + bitWords * sizeof(uint64_t);
+    offsets[6] = offsets[5] + align8(bitWords * sizeof(uint32_t));
+    return offsets[6] + align8(sampleCount * sizeof(uint32_t));
+}
+
+void FMIndex::attach(const char* base) {
+    header = reinterpret_cast<const Header*>(base);
+    rows = static_cast<size_t>(header->length) + 1;
+
+    size_t offsets[7];
+    imageBytes = layout(rows, static_cast<size_t>(header->sampleCount), offsets);
+    bwt = reinterpret_cast<const uint64_t*>(base + offsets[1]);
+    special = reinterpret_cast<const uint64_t*>(base + offsets[2]);
+    rankBlocks = reinterpret_cast<const uint32_t*>(base + offsets[3]);
+    sampled = reinterpret_cast<const uint64_t*>(base + offsets[4]);
+    sampledRank = reinterpret_cast<const uint32_t*>(base + offsets[5]);
+    samples = reinterpret_cast<const uint32_t*>(base + offsets[6]);
+
+    C[0] = 1;
+    for (int s = 0; s < 5; s++) C[s + 1] = C[s] + header->symbolCounts[s];
+}
+
+void FMIndex::clear() {
+    storage.clear();
+    storage.shrink_to_fit();
+    mapped.close();
+    header = nullptr;
+    bwt = special = sampled = nullptr;
+    rankBlocks = sampledRank = samples = nullptr;
+    rows = 0;
+    imageBytes = 0;
+    fill(begin(C), end(C), 0);
+}
+
+bool FMIndex::build(const PackedSequence& text, unsigned sampleRate) {
+    clear();
+    if (sampleRate == 0) sampleRate = DEFAULT_SAMPLE_RATE;
+
+    SuffixArrayIndex suffixes;
+    if (!suffixes.build(text, false)) return false;
+
+    size_t n = text.size();
+    size_t rowCount = n + 1;
+    size_t sampleCount = n / sampleRate + 1;
+    size_t offsets[7];
+    size_t total = layout(rowCount, sampleCount, offsets);
+    storage.assign(total / sizeof(uint64_t), 0);
+
+    char* base = reinterpret_cast<char*>(storage.data());
+    Header* head = reinterpret_cast<Header*>(base);
+    memcpy(head->magic, FM_MAGIC, sizeof(FM_MAGIC));
+    head->length = n;
+    head->sampleRate = sampleRate;
+    head->textHash = SuffixArrayIndex::fingerprint(text);
+    head->sampleCount = sampleCount;
+
+    uint64_t* bwtOut = reinterpret_cast<uint64_t*>(base + offsets[1]);
+    uint64_t* specialOut = reinterpret_cast<uint64_t*>(base + offsets[2]);
+    uint32_t* blocksOut = reinterpret_cast<uint32_t*>(base + offsets[3]);
+    uint64_t* sampledOut = reinterpret_cast<uint64_t*>(base + offsets[4]);
+    uint32_t* sampledRankOut = reinterpret_cast<uint32_t*>(base + offsets[5]);
+    uint32_t* samplesOut = reinterpret_cast<uint32_t*>(base + offsets[6]);
+
+    uint32_t running[RANK_FIELDS] = { 0, 0, 0, 0, 0 };
+    size_t sampleIndex = 0;
+    for (size_t row = 0; row <= rowCount; row++) {
+        if (row % RANK_BLOCK == 0) {
+            memcpy(blocksOut + (row / RANK_BLOCK) * RANK_FIELDS, running, sizeof(running));
+        }
+        if ((row & 63) == 0 && row < rowCount) {
+            sampledRankOut[row >> 6] = static_cast<uint32_t>(sampleIndex);
+        }
+        if (row == rowCount) break;
+
+        size_t pos = row == 0 ? n : suffixes.suffixAt(row - 1);
+        if (pos % sampleRate == 0) {
+            sampledOut[row >> 6] |= 1ULL << (row & 63);
+            samplesOut[sampleIndex++] = static_cast<uint32_t>(pos);
+        }
+
+        uint64_t code = 0;
+        if (pos == 0) {
+            head->dollarRow = row;
+            specialOut[row >> 6] |= 1ULL << (row & 63);
+            running[4]++;
+        }
+        else if (text.isN(pos - 1)) {
+            specialOut[row >> 6] |= 1ULL << (row & 63);
+            running[4]++;
+            head->symbolCounts[SYMBOL_N]++;
+        }
+        else {
+            code = text.code(pos - 1);
+            head->symbolCounts[code]++;
+        }
+        bwtOut[row >> 5] |= code << ((row & 31) * 2);
+        running[code]++;
+    }
+
+    attach(base);
+    return true;
+}
+
+bool FMIndex::save(const string& filename) const {
+    if (!isBuilt()) return false;
+
+    ofstream out(filename, ios::binary);
+    if (!out.is_open()) {
+        cerr << "Error: Could not write index: " << filename << '\n';
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(header), imageBytes);
+    return static_cast<bool>(out);
+}
+
+bool FMIndex::load(const string& filename) {
+    clear();
+    if (!mapped.open(filename) || mapped.size() < sizeof(Header)) {
+        cerr << "Error: Could not map index: " << filename << '\n';
+        mapped.close();
+        return false;
+    }
+
+    const Header* head = reinterpret_cast<const Header*>(mapped.getData());
+    size_t offsets[7];
+    if (memcmp(head->magic, FM_MAGIC, sizeof(FM_MAGIC)) != 0 || head->sampleRate == 0 ||
+        mapped.size() != layout(static_cast<size_t>(head->length) + 1,
+            static_cast<size_t>(head->sampleCount), offsets)) {
+        cerr << "Error: Not an FM-index file: " << filename << '\n';
+        mapped.close();
+        return false;
+    }
+
+    attach(mapped.getData());
+    return true;
+}
+
+bool FMIndex::matches(const PackedSequence& text) const {
+    return isBuilt() && text.size() == header->length &&
+        SuffixArrayIndex::fingerprint(text) == header->textHash;
+}
+
+// Occurrences of `symbol` in BWT rows [0, row).
+size_t FMIndex::rank(int symbol, size_t row) const {
+    size_t block = row / RANK_BLOCK;
+    const uint32_t* counts = rankBlocks + block * RANK_FIELDS;
+
+    size_t specials = counts[4];
+    size_t lastBitWord = row >> 6;
+    for (size_t w = block * (RANK_BLOCK / 64); w < lastBitWord; w++) {
+        specials += popcount(special[w]);
+    }
+    if (row & 63) {
+        specials += popcount(special[lastBitWord] & ((1ULL << (row & 63)) - 1));
+    }
+
+    if (symbol == SYMBOL_N) {
+        return specials - (header->dollarRow < row ? 1 : 0);
+    }
+
+    size_t raw = counts[symbol];
+    size_t lastWord = row >> 5;
+    for (size_t w = block * (RANK_BLOCK / 32); w < lastWord; w++) {
+        raw += popcount(matchMask(bwt[w], symbol));
+    }
+    if (row & 31) {
+        raw += popcount(matchMask(bwt[lastWord], symbol) & ((1ULL << ((row & 31) * 2)) - 1));
+    }
+
+    // $ and N rows are stored as code 0 (A).
+    return symbol == 0 ? raw - specials : raw;
+}
+
+int FMIndex::symbolAt(size_t row) const {
+    if ((special[row >> 6] >> (row & 63)) & 1) {
+        return row == header->dollarRow ? SYMBOL_DOLLAR : SYMBOL_N;
+    }
+    return static_cast<int>((bwt[row >> 5] >> ((row & 31) * 2)) & 3);
+}
+
+pair<size_t, size_t> FMIndex::findRange(const string& pat) const {
+    if (!isBuilt() || pat.empty()) return { 0, 0 };
+
+    size_t lo = 0, hi = rows;
+    for (size_t i = pat.size(); i-- > 0; ) {
+        int symbol = symbolOf(pat[i]);
+        if (symbol < 0) return { 0, 0 };
+        lo = C[symbol] + rank(symbol, lo);
+        hi = C[symbol] + rank(symbol, hi);
+        if (lo >= hi) return { 0, 0 };
+    }
+    return { lo, hi };
+}
+
+size_t FMIndex::count(const string& pat) const {
+    auto range = findRange(pat);
+    return range.second - range.first;
+}
+
+// Walks LF-mapping backwards until a sampled row; at most sampleRate - 1 steps.
+size_t FMIndex::locateRow(size_t row) const {
+    size_t steps = 0;
+    while (!isSampled(row)) {
+        int symbol = symbolAt(row);
+        row = C[symbol] + rank(symbol, row);
+        steps++;
+    }
+    size_t word = row >> 6;
+    size_t index = sampledRank[word] + popcount(sampled[word] & ((1ULL << (row & 63)) - 1));
+    return samples[index] + steps;
+}
+
+vector<uint64_t> FMIndex::locate(const string& pat) const {
+    auto range = findRange(pat);
+    vector<uint64_t> result;
+    result.reserve(range.second - range.first);
+    for (size_t row = range.first; row < range.second; row++) {
+        result.push_back(locateRow(row));
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
\ No newline at end of file
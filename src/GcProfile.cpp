@@ -0,0 +1,217 @@
+#include "GcProfile.h"
+#include "PackedSequence.h"
+#include "SequenceLoader.h"
+#include "MatchSink.h"
+#include "ParallelJobs.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <thread>
+
+using namespace std;
+
+static const size_t JOB_WINDOWS = 1 << 14;
+
+// Adds the G and C counts of [begin, end) using the two bit planes of each word.
+// N slots hold A, so they never count as G or C.
+static void countGC(const PackedSequence& seq, size_t begin, size_t end, size_t& g, size_t& c) {
+    const uint64_t lowBits = 0x5555555555555555ULL;
+    while (begin < end) {
+        size_t w = begin / PackedSequence::BASES_PER_WORD;
+        size_t from = begin % PackedSequence::BASES_PER_WORD;
+        size_t to = min(PackedSequence::BASES_PER_WORD, end - w * PackedSequence::BASES_PER_WORD);
+        uint64_t mask = (to == PackedSequence::BASES_PER_WORD ? ~0ULL : (1ULL << (to * 2)) - 1)
+            & ~((1ULL << (from * 2)) - 1);
+
+        uint64_t word = seq.word(w);
+        uint64_t lo = word & lowBits & mask;
+        uint64_t hi = (word >> 1) & lowBits & mask;
+        c += popcount(lo & ~hi);
+        g += popcount(hi & ~lo);
+        begin = w * PackedSequence::BASES_PER_WORD + to;
+    }
+}
+
+// N bases in [begin, end); cursor only moves forward, so windows must arrive in order.
+static size_t countN(const vector<NRun>& runs, size_t& cursor, size_t begin, size_t end) {
+    while (cursor < runs.size() && runs[cursor].start + runs[cursor].length <= begin) cursor++;
+    size_t n = 0;
+    for (size_t i = cursor; i < runs.size() && runs[i].start < end; i++) {
+        n += min(end, runs[i].start + runs[i].length) - max(begin, runs[i].start);
+    }
+    return n;
+}
+
+// Enough windows to reach the end of the range, but none starting at or past
+// it, which a step longer than the window would otherwise produce.
+static size_t windowsIn(size_t length, size_t window, size_t step) {
+    if (length == 0) return 0;
+    if (length <= window) return 1;
+    return min((length - window + step - 1) / step + 1, (length + step - 1) / step);
+}
+
+// Windows first..last-1 of the range [begin, end).
+static void computeRange(const PackedSequence& seq, size_t begin, size_t end, size_t first,
+    size_t last, size_t window, size_t step, vector<GcWindow>& out)
+{
+    const vector<NRun>& runs = seq.getNRuns();
+    size_t firstStart = begin + first * step;
+    size_t cursor = static_cast<size_t>(lower_bound(runs.begin(), runs.end(), firstStart,
+        [](const NRun& r, size_t p) { return r.start + r.length <= p; }) - runs.begin());
+
+    size_t g = 0, c = 0;
+    size_t prevStart = 0, prevEnd = 0;
+    out.reserve(out.size() + (last - first));
+    for (size_t k = first; k < last; k++) {
+        size_t start = begin + k * step;
+        size_t stop = min(start + window, end);
+        if (k == first || start >= prevEnd) {
+            g = c = 0;
+            countGC(seq, start, stop, g, c);
+        }
+        else {
+            size_t leftG = 0, leftC = 0;
+            countGC(seq, prevStart, start, leftG, leftC);
+            countGC(seq, prevEnd, stop, g, c);
+            g -= leftG;
+            c -= leftC;
+        }
+        prevStart = start;
+        prevEnd = stop;
+
+        GcWindow w;
+        w.start = start;
+        w.end = stop;
+        w.g = static_cast<uint32_t>(g);
+        w.c = static_cast<uint32_t>(c);
+        w.bases = static_cast<uint32_t>(stop - start - countN(runs, cursor, start, stop));
+        out.push_back(w);
+    }
+}
+
+vector<GcWindow> GcProfile::compute(const PackedSequence& seq, size_t begin, size_t end,
+    size_t window, size_t step)
+{
+    vector<GcWindow> windows;
+    if (window == 0 || step == 0 || begin >= end) return windows;
+    computeRange(seq, begin, end, 0, windowsIn(end - begin, window, step), window, step, windows);
+    return windows;
+}
+
+static void appendNumber(string& out, size_t value) {
+    char digits[24];
+    auto result = to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+struct WindowJob {
+    size_t range;
+    size_t first;
+    size_t last;
+};
+
+struct TrackText {
+    string gc;
+    string skew;
+};
+
+static void formatJob(const PackedSequence& seq, const vector<FastaRecord>& records,
+    const vector<RecordRange>& ranges, const WindowJob& job, size_t storeOffset, size_t window,
+    size_t step, GcProfile::Format format, bool wantGc, bool wantSkew, TrackText& text,
+    size_t& written)
+{
+    const RecordRange& range = ranges[job.range];
+    const FastaRecord& record = records[range.record];
+    size_t toRecord = storeOffset + record.start - record.offset;
+
+    vector<GcWindow> windows;
+    computeRange(seq, range.begin, range.end, job.first, job.last, window, step, windows);
+
+    bool inBlock = false;
+    for (const GcWindow& w : windows) {
+        if (w.bases == 0) {
+            inBlock = false;
+            continue;
+        }
+        size_t start = w.start + toRecord;
+        if (format == GcProfile::WIG) {
+            if (!inBlock) {
+                string header = "fixedStep chrom=" + record.name + " start=" + to_string(start + 1)
+                    + " step=" + to_string(step) + " span=" + to_string(min(window, step)) + "\n";
+                if (wantGc) text.gc += header;
+                if (wantSkew) text.skew += header;
+                inBlock = true;
+            }
+            if (wantGc) {
+                BufferedWriter::appendFixed(text.gc, w.gcPercent(), 2);
+                text.gc += '\n';
+            }
+            if (wantSkew) {
+                BufferedWriter::appendFixed(text.skew, w.skew(), 4);
+                text.skew += '\n';
+            }
+        }
+        else {
+            // Like the WIG span, a row covers min(window, step) bases so sliding
+            // windows do not overlap; the last window may be shorter still.
+            size_t stop = min(w.end, w.start + min(window, step)) + toRecord;
+            for (int track = 0; track < 2; track++) {
+                if (!(track == 0 ? wantGc : wantSkew)) continue;
+                string& out = track == 0 ? text.gc : text.skew;
+                out += record.name;
+                out += '\t';
+                appendNumber(out, start);
+                out += '\t';
+                appendNumber(out, stop);
+                out += '\t';
+                BufferedWriter::appendFixed(out, track == 0 ? w.gcPercent() : w.skew(), track == 0 ? 2 : 4);
+                out += '\n';
+            }
+        }
+        written++;
+    }
+}
+
+size_t GcProfile::write(const PackedSequence& seq, const vector<FastaRecord>& records,
+    size_t storeOffset, size_t window, size_t step, Format format,
+    BufferedWriter* gcOut, BufferedWriter* skewOut, unsigned threadCount)
+{
+    if (window == 0 || step == 0 || (!gcOut && !skewOut)) return 0;
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+
+    string trackType = format == WIG ? "wiggle_0" : "bedGraph";
+    if (gcOut) gcOut->append("track type=" + trackType + " name=\"GC%\" description=\"GC percent, "
+        + to_string(window) + " bp windows\"\n");
+    if (skewOut) skewOut->append("track type=" + trackType + " name=\"GC skew\" description=\"(G-C)/(G+C), "
+        + to_string(window) + " bp windows\"\n");
+
+    vector<RecordRange> ranges = SequenceLoader::recordRanges(records, storeOffset, seq.size());
+    vector<WindowJob> jobs;
+    for (size_t s = 0; s < ranges.size(); s++) {
+        size_t count = windowsIn(ranges[s].end - ranges[s].begin, window, step);
+        for (size_t first = 0; first < count; first += JOB_WINDOWS) {
+            jobs.push_back({ s, first, min(count, first + JOB_WINDOWS) });
+        }
+    }
+
+    // Jobs are formatted in parallel a batch at a time and written in order,
+    // so memory stays bounded by the batch rather than the genome.
+    size_t written = 0;
+    size_t batchSize = static_cast<size_t>(threadCount) * 4;
+    for (size_t batchStart = 0; batchStart < jobs.size(); batchStart += batchSize) {
+        size_t batchEnd = min(jobs.size(), batchStart + batchSize);
+        vector<TrackText> texts(batchEnd - batchStart);
+        vector<size_t> counts(batchEnd - batchStart, 0);
+        ParallelJobs::run(batchStart, batchEnd, threadCount, [&](size_t j) {
+            formatJob(seq, records, ranges, jobs[j], storeOffset, window, step, format,
+                gcOut != nullptr, skewOut != nullptr, texts[j - batchStart], counts[j - batchStart]);
+        });
+
+        for (size_t j = 0; j < texts.size(); j++) {
+            if (gcOut) gcOut->append(texts[j].gc);
+            if (skewOut) skewOut->append(texts[j].skew);
+            written += counts[j];
+        }
+    }
+    return written;
+}
\ No newline at end of file
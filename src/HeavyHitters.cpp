@@ -0,0 +1,70 @@
+#include "HeavyHitters.h"
+#include <algorithm>
+
+using namespace std;
+
+SpaceSaving::SpaceSaving(size_t capacity) : capacity(max<size_t>(1, capacity)), total(0) {
+    heap.reserve(this->capacity);
+    position.reserve(this->capacity);
+}
+
+void SpaceSaving::swapEntries(size_t a, size_t b) {
+    swap(heap[a], heap[b]);
+    position[heap[a].code] = a;
+    position[heap[b].code] = b;
+}
+
+void SpaceSaving::siftDown(size_t i) {
+    size_t n = heap.size();
+    while (true) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < n && heap[left].count < heap[smallest].count) smallest = left;
+        if (right < n && heap[right].count < heap[smallest].count) smallest = right;
+        if (smallest == i) return;
+        swapEntries(i, smallest);
+        i = smallest;
+    }
+}
+
+void SpaceSaving::add(uint64_t code) {
+    total++;
+
+    auto it = position.find(code);
+    if (it != position.end()) {
+        heap[it->second].count++;
+        siftDown(it->second);
+        return;
+    }
+
+    if (heap.size() < capacity) {
+        // A new key starts at count 1, the smallest possible value, so it sifts up.
+        heap.push_back({ code, 1, 0 });
+        size_t i = heap.size() - 1;
+        position[code] = i;
+        while (i > 0 && heap[(i - 1) / 2].count > heap[i].count) {
+            swapEntries(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+        return;
+    }
+
+    HeavyHitter& minimum = heap[0];
+    position.erase(minimum.code);
+    minimum.error = minimum.count;
+    minimum.count++;
+    minimum.code = code;
+    position[code] = 0;
+    siftDown(0);
+}
+
+vector<HeavyHitter> SpaceSaving::top(size_t n) const {
+    vector<HeavyHitter> result(heap);
+    sort(result.begin(), result.end(),
+        [](const HeavyHitter& a, const HeavyHitter& b) {
+            return a.count > b.count;
+        });
+    if (result.size() > n) result.resize(n);
+    return result;
+}
\ No newline at end of file
@@ -1,9 +1,163 @@
 #include "KmerAnalyzer.h"
+#include "PackedSequence.h"
+#include "DNAUtils.h"
+#include "SequenceLoader.h"
+#include "ParallelJobs.h"
 #include <algorithm>
 #include <queue>
+#include <cstdint>
+#include <thread>
 
 using namespace std;
 
+static uint64_t kmerMask(int k) {
+    return (k >= 32) ? ~0ULL : ((1ULL << (2 * k)) - 1);
+}
+
+// Rolls the forward code and its reverse complement together; in canonical
+// mode the smaller of the two is reported, so both strands share one key.
+struct RollingKmer {
+    uint64_t mask;
+    unsigned rcShift;
+    int k;
+    bool canonical;
+    uint64_t fwd;
+    uint64_t rc;
+    int valid;
+
+    RollingKmer(int k, bool canonical)
+        : mask(kmerMask(k)), rcShift(static_cast<unsigned>(2 * (k - 1))), k(k),
+        canonical(canonical), fwd(0), rc(0), valid(0) {
+    }
+
+    void reset() {
+        fwd = rc = 0;
+        valid = 0;
+    }
+
+    bool push(uint64_t c, uint64_t& value) {
+        fwd = ((fwd << 2) | c) & mask;
+        rc = (rc >> 2) | ((3 - c) << rcShift);
+        if (++valid < k) return false;
+        value = (canonical && rc < fwd) ? rc : fwd;
+        return true;
+    }
+};
+
+// Calls fn(code) for every N-free k-mer that lies entirely inside [begin, end).
+template <typename Fn>
+static void scanKmers(const PackedSequence& seq, size_t begin, size_t end, int k,
+    bool canonical, Fn&& fn)
+{
+    RollingKmer roller(k, canonical);
+    uint64_t code = 0;
+
+    size_t i = begin;
+    while (i < end) {
+        size_t w = i / PackedSequence::BASES_PER_WORD;
+        size_t wordEnd = min(end, (w + 1) * PackedSequence::BASES_PER_WORD);
+        uint64_t bits = seq.word(w) >> ((i % PackedSequence::BASES_PER_WORD) * 2);
+        bool hasN = seq.wordHasN(w);
+
+        for (; i < wordEnd; i++, bits >>= 2) {
+            if (hasN && seq.isN(i)) {
+                roller.reset();
+                continue;
+            }
+            if (roller.push(bits & 3, code)) fn(code);
+        }
+    }
+}
+
+template <typename Fn>
+static void scanKmers(const string& seq, size_t begin, size_t end, int k,
+    bool canonical, Fn&& fn)
+{
+    RollingKmer roller(k, canonical);
+    uint64_t code = 0;
+
+    for (size_t i = begin; i < end; i++) {
+        uint64_t c;
+        switch (seq[i]) {
+        case 'A': c = 0; break;
+        case 'C': c = 1; break;
+        case 'G': c = 2; break;
+        case 'T': c = 3; break;
+        default:
+            roller.reset();
+            continue;
+        }
+        if (roller.push(c, code)) fn(code);
+    }
+}
+
+// A packed sequence together with the records in it.
+struct RecordText {
+    const PackedSequence& seq;
+    const vector<RecordRange>& ranges;
+
+    size_t size() const { return seq.size(); }
+};
+
+// Scans each record part of [begin, end) separately, so k-mers stop at record ends.
+template <typename Fn>
+static void scanKmers(const RecordText& text, size_t begin, size_t end, int k,
+    bool canonical, Fn&& fn)
+{
+    SequenceLoader::forEachRangePart(text.ranges, begin, end, static_cast<size_t>(k),
+        [&](size_t from, size_t to) {
+            scanKmers(text.seq, from, to, k, canonical, fn);
+            return true;
+        });
+}
+
+template <typename Seq>
+static KmerTable countEncodedImpl(const Seq& seq, int k, bool canonical) {
+    if (k <= 0 || k > KmerTable::MAX_K || k > static_cast<int>(seq.size())) {
+        return KmerTable(k);
+    }
+
+    size_t expected = min<size_t>(seq.size(), (k < 16) ? (1ULL << (2 * k)) : seq.size()) / 4;
+    KmerTable table(k, expected);
+    scanKmers(seq, 0, seq.size(), k, canonical, [&](uint64_t code) { table.add(code); });
+    return table;
+}
+
+static vector<pair<string, int>> decodeEntries(const vector<pair<uint64_t, uint32_t>>& entries,
+    int n, int k)
+{
+    size_t limit = min<size_t>(max(n, 0), entries.size());
+    vector<pair<string, int>> result;
+    result.reserve(limit);
+    for (size_t i = 0; i < limit; i++) {
+        result.emplace_back(KmerTable::decode(entries[i].first, k), static_cast<int>(entries[i].second));
+    }
+    return result;
+}
+
+// Partitions split on high hash bits; KmerTable places keys by the low ones.
+static unsigned partitionOf(uint64_t code, unsigned partitionCount) {
+    return static_cast<unsigned>((KmerTable::hash(code) >> 40) % partitionCount);
+}
+
+static size_t entryCount(const KmerTable& table) { return table.size(); }
+
+static size_t entryCount(const vector<KmerTable>& tables) {
+    size_t total = 0;
+    for (const KmerTable& table : tables) total += table.size();
+    return total;
+}
+
+template <typename Fn>
+static void forEachEntry(const KmerTable& table, Fn&& fn) {
+    table.forEach(fn);
+}
+
+template <typename Fn>
+static void forEachEntry(const vector<KmerTable>& tables, Fn&& fn) {
+    for (const KmerTable& table : tables) table.forEach(fn);
+}
+
 unordered_map<string, int> KmerAnalyzer::count(const string& seq, int k) {
     unordered_map<string, int> kmerCounts;
 
@@ -19,6 +173,48 @@ unordered_map<string, int> KmerAnalyzer::count(const string& seq, int k) {
     return kmerCounts;
 }
 
+unordered_map<string, int> KmerAnalyzer::count(const PackedSequence& seq, const vector<RecordRange>& ranges,
+    int k, bool canonical)
+{
+    unordered_map<string, int> kmerCounts;
+
+    if (k <= 0 || k > static_cast<int>(seq.size())) {
+        return kmerCounts;
+    }
+
+    if (k > KmerTable::MAX_K) {
+        for (const RecordRange& range : ranges) {
+            for (size_t i = range.begin; i + k <= range.end; i++) {
+                if (seq.rangeHasN(i, k)) continue;
+                string kmer = seq.toString(i, k);
+                if (canonical) {
+                    string rc = DNAUtils::reverseComplement(kmer);
+                    if (rc < kmer) kmer.swap(rc);
+                }
+                kmerCounts[kmer]++;
+            }
+        }
+        return kmerCounts;
+    }
+
+    KmerTable table = countEncoded(seq, ranges, k, canonical);
+    kmerCounts.reserve(table.size());
+    table.forEach([&](uint64_t code, uint32_t count) {
+        kmerCounts.emplace(KmerTable::decode(code, k), static_cast<int>(count));
+    });
+    return kmerCounts;
+}
+
+KmerTable KmerAnalyzer::countEncoded(const string& seq, int k, bool canonical) {
+    return countEncodedImpl(seq, k, canonical);
+}
+
+KmerTable KmerAnalyzer::countEncoded(const PackedSequence& seq, const vector<RecordRange>& ranges, int k,
+    bool canonical)
+{
+    return countEncodedImpl(RecordText{ seq, ranges }, k, canonical);
+}
+
 vector<pair<string, int>> KmerAnalyzer::topKmers(
     const unordered_map<string, int>& kmers, int n)
 {
@@ -65,4 +261,218 @@ vector<pair<string, int>> KmerAnalyzer::topKmersHeap(
 
     reverse(result.begin(), result.end());
     return result;
+}
+
+bool KmerAnalyzer::useDense(size_t seqLen, int k, size_t memoryBudget) {
+    if (k <= 0 || k > static_cast<int>(seqLen)) return false;
+    return DenseKmerCounts::requiredBytes(k, seqLen - k + 1) <= memoryBudget;
+}
+
+template <typename Seq, typename T>
+static void fillDense(const Seq& seq, int k, bool canonical, T* counts) {
+    scanKmers(seq, 0, seq.size(), k, canonical, [&](uint64_t code) { counts[code]++; });
+}
+
+template <typename Seq>
+static DenseKmerCounts countDenseImpl(const Seq& seq, int k, bool canonical) {
+    if (k <= 0 || k > static_cast<int>(seq.size()) ||
+        DenseKmerCounts::requiredBytes(k, seq.size()) == SIZE_MAX) {
+        return DenseKmerCounts();
+    }
+
+    DenseKmerCounts counts(k, seq.size() - k + 1);
+    switch (counts.getWidth()) {
+    case 1: fillDense(seq, k, canonical, counts.data8()); break;
+    case 2: fillDense(seq, k, canonical, counts.data16()); break;
+    case 4: fillDense(seq, k, canonical, counts.data32()); break;
+    default: fillDense(seq, k, canonical, counts.data64()); break;
+    }
+    return counts;
+}
+
+DenseKmerCounts KmerAnalyzer::countDense(const string& seq, int k, bool canonical) {
+    return countDenseImpl(seq, k, canonical);
+}
+
+DenseKmerCounts KmerAnalyzer::countDense(const PackedSequence& seq, const vector<RecordRange>& ranges, int k,
+    bool canonical)
+{
+    return countDenseImpl(RecordText{ seq, ranges }, k, canonical);
+}
+
+vector<pair<string, int>> KmerAnalyzer::topKmers(const DenseKmerCounts& kmers, int n) {
+    using CodePair = pair<uint64_t, uint64_t>;
+
+    auto comparator = [](const CodePair& a, const CodePair& b) {
+        return a.second > b.second;
+        };
+
+    if (n <= 0) return {};
+    vector<CodePair> heap;
+    heap.reserve(n + 1);
+
+    kmers.forEach([&](uint64_t code, uint64_t count) {
+        if (static_cast<int>(heap.size()) < n) {
+            heap.emplace_back(code, count);
+            push_heap(heap.begin(), heap.end(), comparator);
+        }
+        else if (count > heap.front().second) {
+            pop_heap(heap.begin(), heap.end(), comparator);
+            heap.back() = CodePair(code, count);
+            push_heap(heap.begin(), heap.end(), comparator);
+        }
+    });
+
+    sort_heap(heap.begin(), heap.end(), comparator);
+
+    vector<pair<string, int>> result;
+    result.reserve(heap.size());
+    for (const auto& entry : heap) {
+        result.emplace_back(KmerTable::decode(entry.first, kmers.getK()), static_cast<int>(entry.second));
+    }
+    return result;
+}
+
+vector<KmerTable> KmerAnalyzer::countParallel(const PackedSequence& seq, const vector<RecordRange>& ranges, int k,
+    unsigned threadCount, bool canonical)
+{
+    RecordText text{ seq, ranges };
+    vector<KmerTable> partitions;
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+
+    const size_t minSlice = 1 << 16;
+    if (k <= 0 || k > KmerTable::MAX_K || k > static_cast<int>(seq.size())) {
+        partitions.emplace_back(k);
+        return partitions;
+    }
+    threadCount = static_cast<unsigned>(min<size_t>(threadCount, seq.size() / minSlice));
+    if (threadCount <= 1) {
+        partitions.push_back(countEncoded(seq, ranges, k, canonical));
+        return partitions;
+    }
+
+    // Each thread counts its slice into its own table per partition, then each
+    // thread folds one partition column together; no table is ever shared.
+    const unsigned partitionCount = threadCount;
+    vector<vector<KmerTable>> local(threadCount);
+    size_t sliceLen = (seq.size() + threadCount - 1) / threadCount;
+
+    ParallelJobs::run(0, threadCount, threadCount, [&](size_t t) {
+        size_t begin = min(seq.size(), t * sliceLen);
+        size_t end = min(seq.size(), begin + sliceLen + k - 1);
+        for (unsigned p = 0; p < partitionCount; p++) local[t].emplace_back(k);
+
+        scanKmers(text, begin, end, k, canonical, [&](uint64_t code) {
+            local[t][partitionOf(code, partitionCount)].add(code);
+        });
+    });
+
+    partitions.resize(partitionCount);
+    ParallelJobs::run(0, partitionCount, threadCount, [&](size_t p) {
+        // Sized for the sum up front: inserting in slot order into a table
+        // that is still growing piles keys into long probe runs.
+        size_t expected = 0;
+        for (unsigned t = 0; t < threadCount; t++) expected += local[t][p].size();
+        partitions[p] = KmerTable(k, expected);
+        for (unsigned t = 0; t < threadCount; t++) {
+            local[t][p].forEach([&](uint64_t code, uint32_t count) { partitions[p].add(code, count); });
+            local[t][p] = KmerTable(k);
+        }
+    });
+    return partitions;
+}
+
+template <typename Tables>
+static vector<pair<string, int>> topKmersSorted(const Tables& tables, int n, int k) {
+    vector<pair<uint64_t, uint32_t>> entries;
+    entries.reserve(entryCount(tables));
+    forEachEntry(tables, [&](uint64_t code, uint32_t count) { entries.emplace_back(code, count); });
+
+    sort(entries.begin(), entries.end(),
+        [](const pair<uint64_t, uint32_t>& a, const pair<uint64_t, uint32_t>& b) {
+            return a.second > b.second;
+        });
+
+    return decodeEntries(entries, n, k);
+}
+
+template <typename Tables>
+static vector<pair<string, int>> topKmersBoundedHeap(const Tables& tables, int n, int k) {
+    using CodePair = pair<uint64_t, uint32_t>;
+
+    auto comparator = [](const CodePair& a, const CodePair& b) {
+        return a.second > b.second;
+        };
+
+    priority_queue<CodePair, vector<CodePair>, decltype(comparator)> minHeap(comparator);
+
+    forEachEntry(tables, [&](uint64_t code, uint32_t count) {
+        if (static_cast<int>(minHeap.size()) < n) {
+            minHeap.emplace(code, count);
+        }
+        else if (n > 0 && count > minHeap.top().second) {
+            minHeap.pop();
+            minHeap.emplace(code, count);
+        }
+    });
+
+    vector<pair<string, int>> result;
+    while (!minHeap.empty()) {
+        result.emplace_back(KmerTable::decode(minHeap.top().first, k),
+            static_cast<int>(minHeap.top().second));
+        minHeap.pop();
+    }
+
+    reverse(result.begin(), result.end());
+    return result;
+}
+
+vector<pair<string, int>> KmerAnalyzer::topKmers(const KmerTable& kmers, int n) {
+    return topKmersSorted(kmers, n, kmers.getK());
+}
+
+vector<pair<string, int>> KmerAnalyzer::topKmersHeap(const KmerTable& kmers, int n) {
+    return topKmersBoundedHeap(kmers, n, kmers.getK());
+}
+
+vector<pair<string, int>> KmerAnalyzer::topKmers(const vector<KmerTable>& partitions, int n) {
+    return topKmersSorted(partitions, n, partitions.empty() ? 0 : partitions[0].getK());
+}
+
+vector<pair<string, int>> KmerAnalyzer::topKmersHeap(const vector<KmerTable>& partitions, int n) {
+    return topKmersBoundedHeap(partitions, n, partitions.empty() ? 0 : partitions[0].getK());
+}
+
+vector<HeavyHitter> KmerAnalyzer::topKmersBounded(const PackedSequence& seq, const vector<RecordRange>& ranges,
+    int k, int n, size_t memoryBudget, bool exactPass, bool canonical)
+{
+    RecordText text{ seq, ranges };
+    if (k <= 0 || k > KmerTable::MAX_K || k > static_cast<int>(seq.size()) || n <= 0) {
+        return {};
+    }
+
+    size_t capacity = max<size_t>(n, memoryBudget / SpaceSaving::BYTES_PER_COUNTER);
+    SpaceSaving summary(capacity);
+    scanKmers(text, 0, seq.size(), k, canonical, [&](uint64_t code) { summary.add(code); });
+
+    if (!exactPass) {
+        return summary.top(n);
+    }
+
+    vector<HeavyHitter> candidates = summary.top(summary.size());
+    KmerTable exact(k, candidates.size());
+    for (const HeavyHitter& candidate : candidates) exact.add(candidate.code);
+
+    scanKmers(text, 0, seq.size(), k, canonical, [&](uint64_t code) { exact.increment(code); });
+
+    for (HeavyHitter& candidate : candidates) {
+        candidate.count = exact.get(candidate.code) - 1;
+        candidate.error = 0;
+    }
+    sort(candidates.begin(), candidates.end(),
+        [](const HeavyHitter& a, const HeavyHitter& b) {
+            return a.count > b.count;
+        });
+    if (candidates.size() > static_cast<size_t>(n)) candidates.resize(n);
+    return candidates;
 }
\ No newline at end of file
@@ -1,82 +1,165 @@
 #include "KmerBST.h"
+#include "KmerTable.h"
+#include "DenseKmerCounts.h"
 #include <algorithm>
+#include <bit>
 
 using namespace std;
 
-KmerBST::KmerBST() : root(nullptr) {}
-
-KmerBST::~KmerBST() {
+KmerBST::KmerBST() : k(0) {
     clear();
 }
 
-KmerNode* KmerBST::insert(KmerNode* node, const string& kmer, int count) {
-    if (!node) {
-        return new KmerNode(kmer, count);
-    }
+size_t KmerBST::fillEytzinger(size_t node, size_t rank) {
+    if (node >= eytzinger.size()) return rank;
+    rank = fillEytzinger(2 * node, rank);
+    eytzinger[node] = sortedKeys[rank];
+    eytzingerRank[node] = static_cast<uint32_t>(rank);
+    rank++;
+    return fillEytzinger(2 * node + 1, rank);
+}
 
-    if (kmer < node->kmer) {
-        node->left = insert(node->left, kmer, count);
-    }
-    else if (kmer > node->kmer) {
-        node->right = insert(node->right, kmer, count);
-    }
-    else {
-        node->count += count;
+void KmerBST::build(vector<pair<uint64_t, uint32_t>> entries, int k) {
+    clear();
+    this->k = k;
+
+    sort(entries.begin(), entries.end());
+    sortedKeys.reserve(entries.size());
+    sortedCounts.reserve(entries.size());
+    countPrefix.assign(entries.size() + 1, 0);
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        sortedKeys.push_back(entries[i].first);
+        sortedCounts.push_back(entries[i].second);
+        countPrefix[i + 1] = countPrefix[i] + entries[i].second;
     }
 
-    return node;
+    eytzinger.assign(entries.size() + 1, 0);
+    eytzingerRank.assign(entries.size() + 1, 0);
+    fillEytzinger(1, 0);
 }
 
-void KmerBST::insert(const string& kmer, int count) {
-    root = insert(root, kmer, count);
+void KmerBST::build(const KmerTable& table) {
+    vector<pair<uint64_t, uint32_t>> entries;
+    entries.reserve(table.size());
+    table.forEach([&](uint64_t code, uint32_t count) { entries.emplace_back(code, count); });
+    build(move(entries), table.getK());
 }
 
-KmerNode* KmerBST::findKmer(KmerNode* node, const string& kmer) const {
-    if (!node || node->kmer == kmer) {
-        return node;
-    }
+void KmerBST::build(const vector<KmerTable>& partitions) {
+    size_t total = 0;
+    for (const KmerTable& table : partitions) total += table.size();
 
-    if (kmer < node->kmer) {
-        return findKmer(node->left, kmer);
+    vector<pair<uint64_t, uint32_t>> entries;
+    entries.reserve(total);
+    for (const KmerTable& table : partitions) {
+        table.forEach([&](uint64_t code, uint32_t count) { entries.emplace_back(code, count); });
     }
-    else {
-        return findKmer(node->right, kmer);
+    build(move(entries), partitions.empty() ? 0 : partitions[0].getK());
+}
+
+void KmerBST::build(const DenseKmerCounts& counts) {
+    vector<pair<uint64_t, uint32_t>> entries;
+    counts.forEach([&](uint64_t code, uint64_t count) {
+        entries.emplace_back(code, static_cast<uint32_t>(min<uint64_t>(count, UINT32_MAX)));
+    });
+    build(move(entries), counts.getK());
+}
+
+// Rank of the first key >= key (size() if none), branch-free descent.
+size_t KmerBST::lowerBound(uint64_t key) const {
+    size_t n = eytzinger.size() - 1;
+    size_t i = 1;
+    while (i <= n) {
+        i = 2 * i + (eytzinger[i] < key);
     }
+    i >>= countr_one(i) + 1;
+    return i == 0 ? n : eytzingerRank[i];
 }
 
 bool KmerBST::contains(const string& kmer) const {
-    return findKmer(root, kmer) != nullptr;
+    return getCount(kmer) > 0;
 }
 
 int KmerBST::getCount(const string& kmer) const {
-    KmerNode* node = findKmer(root, kmer);
-    return node ? node->count : 0;
+    uint64_t key;
+    if (static_cast<int>(kmer.size()) != k || !KmerTable::encode(kmer, key) || sortedKeys.empty()) {
+        return 0;
+    }
+    size_t rank = lowerBound(key);
+    return (rank < sortedKeys.size() && sortedKeys[rank] == key) ? sortedCounts[rank] : 0;
 }
 
-void KmerBST::inOrderTraversal(KmerNode* node,
-    vector<pair<string, int>>& result) const
-{
-    if (!node) return;
-
-    inOrderTraversal(node->left, result);
-    result.emplace_back(node->kmer, node->count);
-    inOrderTraversal(node->right, result);
+vector<pair<string, int>> KmerBST::decodeRange(size_t first, size_t last) const {
+    vector<pair<string, int>> result;
+    result.reserve(last - first);
+    for (size_t i = first; i < last; i++) {
+        result.emplace_back(KmerTable::decode(sortedKeys[i], k), static_cast<int>(sortedCounts[i]));
+    }
+    return result;
 }
 
 vector<pair<string, int>> KmerBST::getAllKmers() const {
-    vector<pair<string, int>> result;
-    inOrderTraversal(root, result);
-    return result;
+    return decodeRange(0, sortedKeys.size());
+}
+
+// Ranks [first, last) of the k-mers starting with prefix (length <= k).
+bool KmerBST::prefixRanks(const string& prefix, size_t& first, size_t& last) const {
+    if (sortedKeys.empty() || static_cast<int>(prefix.size()) > k) return false;
+    if (prefix.empty()) {
+        first = 0;
+        last = sortedKeys.size();
+        return true;
+    }
+
+    uint64_t code;
+    if (!KmerTable::encode(prefix, code)) return false;
+    unsigned shift = static_cast<unsigned>(2 * (k - prefix.size()));
+    uint64_t span = 2 * prefix.size();
+    bool lastPrefix = (span == 64) ? code == UINT64_MAX : code == (1ULL << span) - 1;
+
+    first = lowerBound(code << shift);
+    last = (lastPrefix && k == KmerTable::MAX_K) ? sortedKeys.size() : lowerBound((code + 1) << shift);
+    return true;
 }
 
-void KmerBST::clear(KmerNode* node) {
-    if (!node) return;
-    clear(node->left);
-    clear(node->right);
-    delete node;
+vector<pair<string, int>> KmerBST::getKmersWithPrefix(const string& prefix) const {
+    size_t first, last;
+    if (!prefixRanks(prefix, first, last)) return {};
+    return decodeRange(first, last);
+}
+
+uint64_t KmerBST::countWithPrefix(const string& prefix) const {
+    size_t first, last;
+    if (!prefixRanks(prefix, first, last)) return 0;
+    return countPrefix[last] - countPrefix[first];
+}
+
+vector<pair<string, int>> KmerBST::getKmersInRange(const string& low, const string& high) const {
+    uint64_t lowCode, highCode;
+    if (sortedKeys.empty() || static_cast<int>(low.size()) != k || static_cast<int>(high.size()) != k ||
+        !KmerTable::encode(low, lowCode) || !KmerTable::encode(high, highCode) || highCode < lowCode) {
+        return {};
+    }
+    size_t last = (highCode == UINT64_MAX) ? sortedKeys.size() : lowerBound(highCode + 1);
+    return decodeRange(lowerBound(lowCode), last);
+}
+
+uint64_t KmerBST::countInRange(const string& low, const string& high) const {
+    uint64_t lowCode, highCode;
+    if (sortedKeys.empty() || static_cast<int>(low.size()) != k || static_cast<int>(high.size()) != k ||
+        !KmerTable::encode(low, lowCode) || !KmerTable::encode(high, highCode) || highCode < lowCode) {
+        return 0;
+    }
+    size_t last = (highCode == UINT64_MAX) ? sortedKeys.size() : lowerBound(highCode + 1);
+    return countPrefix[last] - countPrefix[lowerBound(lowCode)];
 }
 
 void KmerBST::clear() {
-    clear(root);
-    root = nullptr;
+    eytzinger.assign(1, 0);
+    eytzingerRank.assign(1, 0);
+    sortedKeys.clear();
+    sortedCounts.clear();
+    countPrefix.assign(1, 0);
+    k = 0;
 }
\ No newline at end of file
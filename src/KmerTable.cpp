@@ -0,0 +1,66 @@
+#include "KmerTable.h"
+
+using namespace std;
+
+KmerTable::KmerTable(int k, size_t expected) : used(0), k(k) {
+    size_t capacity = 16;
+    while (capacity * 7 < expected * 10) capacity <<= 1;
+    slots.assign(capacity, Slot{ 0, 0 });
+    mask = capacity - 1;
+}
+
+void KmerTable::grow() {
+    vector<Slot> old(slots.size() * 2, Slot{ 0, 0 });
+    old.swap(slots);
+    mask = slots.size() - 1;
+
+    for (const Slot& slot : old) {
+        if (slot.count == 0) continue;
+        size_t i = hashKey(slot.key) & mask;
+        while (slots[i].count != 0) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
+
+uint32_t KmerTable::get(uint64_t key) const {
+    size_t i = hashKey(key) & mask;
+    while (slots[i].count != 0) {
+        if (slots[i].key == key) return slots[i].count;
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+void KmerTable::clear() {
+    slots.assign(16, Slot{ 0, 0 });
+    mask = 15;
+    used = 0;
+}
+
+string KmerTable::decode(uint64_t key, int k) {
+    static const char BASES[4] = { 'A', 'C', 'G', 'T' };
+    string kmer(k, 'A');
+    for (int i = k - 1; i >= 0; i--) {
+        kmer[i] = BASES[key & 3];
+        key >>= 2;
+    }
+    return kmer;
+}
+
+bool KmerTable::encode(const string& kmer, uint64_t& key) {
+    if (kmer.empty() || kmer.size() > MAX_K) return false;
+
+    key = 0;
+    for (char c : kmer) {
+        uint64_t code;
+        switch (c) {
+        case 'A': case 'a': code = 0; break;
+        case 'C': case 'c': code = 1; break;
+        case 'G': case 'g': code = 2; break;
+        case 'T': case 't': code = 3; break;
+        default: return false;
+        }
+        key = (key << 2) | code;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+    : data(nullptr), length(0), opened(false),
+    fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr) {
+}
+
+bool MappedFile::open(const string& filename) {
+    close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    length = static_cast<size_t>(fileSize.QuadPart);
+    opened = true;
+    if (length == 0) return true;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        return false;
+    }
+    mappingHandle = mapping;
+
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(static_cast<HANDLE>(fileHandle));
+
+    data = nullptr;
+    length = 0;
+    opened = false;
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile() : data(nullptr), length(0), opened(false), fd(-1) {}
+
+bool MappedFile::open(const string& filename) {
+    close();
+
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat st;
+    if (fstat(file, &st) != 0) {
+        ::close(file);
+        return false;
+    }
+
+    fd = file;
+    length = static_cast<size_t>(st.st_size);
+    opened = true;
+    if (length == 0) return true;
+
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(mapped);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) munmap(const_cast<char*>(data), length);
+    if (fd >= 0) ::close(fd);
+
+    data = nullptr;
+    length = 0;
+    opened = false;
+    fd = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
\ No newline at end of file
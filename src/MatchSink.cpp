@@ -0,0 +1,76 @@
+#include "MatchSink.h"
+#include "SequenceLoader.h"
+#include <charconv>
+
+using namespace std;
+
+BufferedWriter::BufferedWriter(const string& path, size_t bufferBytes)
+    : out(path, ios::binary), threshold(bufferBytes)
+{
+    buffer.reserve(bufferBytes + 256);
+}
+
+BufferedWriter::~BufferedWriter() {
+    flush();
+}
+
+void BufferedWriter::append(const char* data, size_t length) {
+    buffer.append(data, length);
+    if (buffer.size() >= threshold) flush();
+}
+
+void BufferedWriter::append(size_t value) {
+    char digits[24];
+    auto result = to_chars(digits, digits + sizeof(digits), value);
+    append(digits, static_cast<size_t>(result.ptr - digits));
+}
+
+void BufferedWriter::append(double value, int precision) {
+    appendFixed(buffer, value, precision);
+    if (buffer.size() >= threshold) flush();
+}
+
+void BufferedWriter::appendFixed(string& out, double value, int precision) {
+    char digits[32];
+    auto result = to_chars(digits, digits + sizeof(digits), value, chars_format::fixed, precision);
+    out.append(digits, result.ptr);
+}
+
+void BufferedWriter::append(char c) {
+    buffer.push_back(c);
+    if (buffer.size() >= threshold) flush();
+}
+
+void BufferedWriter::flush() {
+    if (buffer.empty() || !out.is_open()) return;
+    out.write(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+BedSink::BedSink(BufferedWriter& out, const vector<FastaRecord>& fastaRecords, size_t offset,
+    size_t matchLength, const string& featureName, char featureStrand)
+    : writer(out), records(fastaRecords), storeOffset(offset), length(matchLength),
+    name(featureName), strand(featureStrand), record(0)
+{
+    if (!records.empty()) record = SequenceLoader::findRecord(records, storeOffset);
+}
+
+bool BedSink::onMatch(size_t pos) {
+    size_t storePos = storeOffset + pos;
+    while (record + 1 < records.size() && records[record + 1].offset <= storePos) record++;
+
+    const FastaRecord& r = records[record];
+    size_t recordPos = storePos - r.offset + r.start;
+    writer.append(r.name);
+    writer.append('\t');
+    writer.append(recordPos);
+    writer.append('\t');
+    writer.append(recordPos + length);
+    writer.append('\t');
+    writer.append(name);
+    writer.append("\t0\t", 3);
+    writer.append(strand);
+    writer.append('\n');
+    count++;
+    return true;
+}
\ No newline at end of file
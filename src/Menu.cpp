@@ -5,21 +5,279 @@
 #include "DNAUtils.h"
 #include "OperationHistory.h"
 #include "KmerBST.h"
+#include "PackedSequence.h"
+#include "SuffixArrayIndex.h"
+#include "FMIndex.h"
+#include "AhoCorasick.h"
+#include "ApproximateSearch.h"
+#include "MatchSink.h"
+#include "RabinKarp.h"
+#include "SequenceStats.h"
+#include "GcProfile.h"
+#include "CpGIslands.h"
+#include "OrfFinder.h"
+#include "TandemRepeats.h"
 
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 #include <algorithm>
+#include <thread>
+#include <memory>
 
 using namespace std;
 
-static void showMenu(bool loaded, const string& header) {
+static const PackedSequence& selectRegion(const PackedSequence& sequence,
+    const vector<FastaRecord>& records, PackedSequence& regionSeq,
+    size_t& storeOffset, string& label)
+{
+    cout << "Region (all, record or record:start-end): ";
+    string region;
+    cin >> region;
+
+    storeOffset = 0;
+    label = "all";
+    if (region == "all" || region == "*") return sequence;
+
+    size_t length = 0;
+    if (!SequenceLoader::resolveRegion(records, region, storeOffset, length)) {
+        cout << "Unknown region '" << region << "', using whole sequence.\n";
+        storeOffset = 0;
+        return sequence;
+    }
+
+    label = region;
+    if (storeOffset == 0 && length == sequence.size()) return sequence;
+    regionSeq = sequence.slice(storeOffset, length);
+    return regionSeq;
+}
+
+static string formatPosition(const vector<FastaRecord>& records, size_t storePos) {
+    const FastaRecord& record = records[SequenceLoader::findRecord(records, storePos)];
+    return record.name + ":" + to_string(storePos - record.offset + record.start + 1);
+}
+
+struct SearchIndexes {
+    SuffixArrayIndex suffixArray;
+    FMIndex fm;
+    unsigned fmSampleRate = FMIndex::DEFAULT_SAMPLE_RATE;
+
+    void clear() {
+        suffixArray.clear();
+        fm.clear();
+    }
+};
+
+// Composition of the whole loaded sequence, computed on first use and kept
+// until the next load. Regions are summarized on demand.
+struct StatsCache {
+    SequenceStats whole;
+    bool valid = false;
+
+    void clear() { valid = false; }
+};
+
+// Characters the loader replaced with N in the records the target overlaps.
+static size_t invalidCharsIn(const vector<FastaRecord>& records, size_t storeOffset, size_t length) {
+    size_t total = 0;
+    for (const RecordRange& range : SequenceLoader::recordRanges(records, storeOffset, length)) {
+        total += records[range.record].invalidChars;
+    }
+    return total;
+}
+
+static SequenceStats getStats(StatsCache& cache, const PackedSequence& sequence,
+    const vector<FastaRecord>& records, const PackedSequence& target, size_t storeOffset,
+    unsigned threadCount)
+{
+    if (&target != &sequence) {
+        SequenceStats region = SequenceStats::compute(target, threadCount);
+        region.invalidChars = invalidCharsIn(records, storeOffset, target.size());
+        return region;
+    }
+    if (!cache.valid) {
+        cache.whole = SequenceStats::compute(sequence, threadCount);
+        cache.whole.invalidChars = invalidCharsIn(records, 0, sequence.size());
+        cache.valid = true;
+    }
+    return cache.whole;
+}
+
+static bool ensureSuffixArray(SearchIndexes& indexes, const PackedSequence& sequence) {
+    if (indexes.suffixArray.matches(sequence)) return true;
+
+    cout << "Building suffix array index...";
+    cout.flush();
+    auto start = chrono::high_resolution_clock::now();
+    bool built = indexes.suffixArray.build(sequence);
+    chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+    if (built) {
+        cout << " done in " << fixed << setprecision(3) << duration.count() << " seconds ("
+            << (indexes.suffixArray.memoryUsage() / (1024 * 1024)) << " MB)\n";
+    }
+    else {
+        cout << " failed\n";
+    }
+    return built;
+}
+
+static bool ensureFMIndex(SearchIndexes& indexes, const PackedSequence& sequence) {
+    if (indexes.fm.matches(sequence)) return true;
+
+    cout << "Building FM-index (SA sample rate " << indexes.fmSampleRate << ")...";
+    cout.flush();
+    auto start = chrono::high_resolution_clock::now();
+    bool built = indexes.fm.build(sequence, indexes.fmSampleRate);
+    chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+    if (built) {
+        cout << " done in " << fixed << setprecision(3) << duration.count() << " seconds ("
+            << setprecision(2) << static_cast<double>(indexes.fm.memoryUsage()) / sequence.size()
+            << " bytes/base)\n";
+    }
+    else {
+        cout << " failed\n";
+    }
+    return built;
+}
+
+static bool ensureIndex(PatternSearch::Algorithm algorithm, SearchIndexes& indexes,
+    const PackedSequence& sequence)
+{
+    if (algorithm == PatternSearch::SUFFIX_ARRAY) return ensureSuffixArray(indexes, sequence);
+    if (algorithm == PatternSearch::FM_INDEX) return ensureFMIndex(indexes, sequence);
+    return true;
+}
+
+// Indexed searches cover the whole loaded sequence; passes on the sorted hits
+// that lie inside one of the target's records, in target coordinates.
+template <typename Position>
+static bool replayInTarget(const vector<Position>& indexed, size_t patLength, size_t storeOffset,
+    const vector<RecordRange>& ranges, MatchSink& sink)
+{
+    size_t r = 0;
+    for (Position hit : indexed) {
+        uint64_t pos = hit;
+        if (pos < storeOffset) continue;
+        size_t local = static_cast<size_t>(pos - storeOffset);
+        while (r < ranges.size() && ranges[r].end <= local) r++;
+        if (r == ranges.size()) break;
+        if (local < ranges[r].begin || local + patLength > ranges[r].end) continue;
+        if (!sink.onMatch(local)) return false;
+    }
+    return true;
+}
+
+// Streams the hits in target coordinates; ranges are the records in the target.
+static bool runAlgorithm(PatternSearch::Algorithm algorithm, const PackedSequence& target,
+    const vector<RecordRange>& ranges, const string& pat, const PackedSequence& sequence,
+    const SearchIndexes& indexes, size_t storeOffset, unsigned threadCount, MatchSink& sink)
+{
+    if (!PatternSearch::isIndexed(algorithm)) {
+        return threadCount > 1 ? PatternSearch::runParallel(algorithm, target, ranges, pat, sink, threadCount)
+            : PatternSearch::run(algorithm, target, ranges, pat, sink);
+    }
+
+    if (algorithm == PatternSearch::SUFFIX_ARRAY) {
+        return replayInTarget(PatternSearch::suffixArray(indexes.suffixArray, sequence, pat), pat.size(),
+            storeOffset, ranges, sink);
+    }
+    return replayInTarget(PatternSearch::fmIndex(indexes.fm, pat), pat.size(), storeOffset, ranges, sink);
+}
+
+static void runAlgorithmStranded(PatternSearch::Algorithm algorithm, const PackedSequence& target,
+    const vector<RecordRange>& ranges, const string& pat, PatternSearch::Strand strand,
+    const PackedSequence& sequence, const SearchIndexes& indexes, size_t storeOffset, unsigned threadCount,
+    MatchSink& plusSink, MatchSink& minusSink)
+{
+    if (!PatternSearch::isIndexed(algorithm)) {
+        PatternSearch::runStranded(algorithm, target, ranges, pat, strand, plusSink, minusSink, threadCount);
+        return;
+    }
+
+    if (strand != PatternSearch::MINUS_STRAND) {
+        runAlgorithm(algorithm, target, ranges, pat, sequence, indexes, storeOffset, threadCount, plusSink);
+    }
+    if (strand != PatternSearch::PLUS_STRAND) {
+        runAlgorithm(algorithm, target, ranges, DNAUtils::reverseComplement(pat), sequence, indexes,
+            storeOffset, threadCount, minusSink);
+    }
+}
+
+static PatternSearch::Strand selectStrand() {
+    cout << "Strand: 1) + (forward)  2) - (reverse complement)  3) Both\n";
+    cout << "Choose: ";
+    int choice;
+    if (!(cin >> choice) || choice < 1 || choice > 3) {
+        cin.clear();
+        cin.ignore(99999, '\n');
+        choice = 1;
+    }
+    return static_cast<PatternSearch::Strand>(choice - 1);
+}
+
+static string formatInterval(const vector<FastaRecord>& records, size_t storeStart, size_t storeEnd) {
+    const FastaRecord& record = records[SequenceLoader::findRecord(records, storeStart)];
+    size_t first = storeStart - record.offset + record.start + 1;
+    return record.name + ":" + to_string(first) + "-" + to_string(first + (storeEnd - storeStart));
+}
+
+// Wall-clock seconds taken by fn().
+template <typename Fn>
+static double timeSeconds(Fn&& fn) {
+    auto start = chrono::high_resolution_clock::now();
+    fn();
+    chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+    return duration.count();
+}
+
+// Search summary shared by the exact and approximate modes: the hit count and
+// time, then the first hits (already formatted) and how many more there were.
+static void printFound(size_t found, const string& qualifier, double seconds,
+    const vector<string>& firstHits)
+{
+    cout << "\nFound " << found << " matches" << qualifier << " in "
+        << fixed << setprecision(6) << seconds << " seconds.\n";
+    if (firstHits.empty()) return;
+
+    cout << "First " << firstHits.size() << " matches:\n";
+    for (const string& hit : firstHits) cout << "  " << hit << "\n";
+    if (found > firstHits.size()) {
+        cout << "  ... and " << (found - firstHits.size()) << " more\n";
+    }
+}
+
+static string searchDetails(const string& pat, const string& region, const string& algorithm,
+    const string& extra, size_t found, double seconds)
+{
+    return "Pattern: " + pat + ", Region: " + region + ", Algorithm: " + algorithm + extra +
+        ", Found: " + to_string(found) + ", Time: " + to_string(seconds) + "s";
+}
+
+// Approximate modes take part in the comparison at distance 0, where their
+// hits must be exactly the exact engines' hits.
+static vector<size_t> approximateStarts(PatternSearch::Algorithm algorithm, const PackedSequence& target,
+    const vector<RecordRange>& ranges, const string& pat, int maxDistance, unsigned threadCount)
+{
+    vector<ApproxMatch> matches = ApproximateSearch::searchParallel(
+        algorithm == PatternSearch::APPROX_HAMMING ? ApproximateSearch::HAMMING : ApproximateSearch::EDIT,
+        target, ranges, pat, maxDistance, threadCount);
+    vector<size_t> starts;
+    starts.reserve(matches.size());
+    for (const ApproxMatch& match : matches) starts.push_back(match.start);
+    return starts;
+}
+
+static void showMenu(bool loaded, const vector<FastaRecord>& records) {
     cout << "\n==== DNA Analyzer ====\n";
     if (!loaded) {
         cout << "[No FASTA file loaded]\n";
     }
     else {
-        cout << "[Loaded: " << header << "]\n";
+        cout << "[Loaded: " << records.front().header;
+        if (records.size() > 1) {
+            cout << " (+" << (records.size() - 1) << " more records)";
+        }
+        cout << "]\n";
     }
 
     cout << "1) Load FASTA file\n";
@@ -31,27 +289,39 @@ static void showMenu(bool loaded, const string& header) {
     cout << "7) Operation History\n";
     cout << "8) Validate Sequence\n";
     cout << "9) Toggle K-mer Algorithm\n";
-    cout << "10) Exit\n";
+    cout << "10) Load Region from Indexed FASTA\n";
+    cout << "11) Set Thread Count\n";
+    cout << "12) Heavy-Hitter K-mers (Bounded Memory)\n";
+    cout << "13) Search Indexes (Build/Save/Load)\n";
+    cout << "14) Motif Library Scan (Aho-Corasick)\n";
+    cout << "15) GC Profile Tracks (bedGraph/WIG)\n";
+    cout << "16) CpG Island Detection\n";
+    cout << "17) Six-Frame ORF Finder\n";
+    cout << "18) Tandem Repeat Detection\n";
+    cout << "19) Exit\n";
     cout << "Choose: ";
 }
 
 void Menu::run(int argc, char* argv[]) {
-    string sequence;
-    string header;
+    PackedSequence sequence;
+    vector<FastaRecord> records;
     bool loaded = false;
     OperationHistory history;
     bool useHeapForKmers = false;
+    unsigned threadCount = max(1u, thread::hardware_concurrency());
+    SearchIndexes indexes;
+    StatsCache stats;
 
     if (argc > 1) {
         string path = argv[1];
-        if (SequenceLoader::loadFASTA(path, sequence, header)) {
+        if (SequenceLoader::loadFASTAMapped(path, sequence, records, threadCount)) {
             loaded = true;
             history.addOperation("Load FASTA", path);
         }
     }
 
     while (true) {
-        showMenu(loaded, header);
+        showMenu(loaded, records);
 
         int choice;
         if (!(cin >> choice)) {
@@ -66,7 +336,9 @@ void Menu::run(int argc, char* argv[]) {
             string path;
             cin >> path;
 
-            if (SequenceLoader::loadFASTA(path, sequence, header)) {
+            if (SequenceLoader::loadFASTAMapped(path, sequence, records, threadCount)) {
+                indexes.clear();
+                stats.clear();
                 loaded = true;
                 history.addOperation("Load FASTA", path);
             }
@@ -79,11 +351,19 @@ void Menu::run(int argc, char* argv[]) {
                 break;
             }
 
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+            vector<RecordRange> ranges = SequenceLoader::recordRanges(records, storeOffset, target.size());
+
             cout << "Enter pattern to search: ";
             string pat;
             cin >> pat;
 
             for (char& c : pat) c = toupper(c);
+            bool degenerate = PatternSearch::isDegenerate(pat);
 
             cout << "\nSelect search algorithm:\n";
             vector<string> algorithms = PatternSearch::getAlgorithmNames();
@@ -100,81 +380,173 @@ void Menu::run(int argc, char* argv[]) {
                 algoChoice = 1;
             }
 
-            vector<int> positions;
             string algoName;
-            auto start = chrono::high_resolution_clock::now();
-            auto end = chrono::high_resolution_clock::now();
-            chrono::duration<double> duration;
 
             if (algoChoice >= 1 && algoChoice <= static_cast<int>(algorithms.size())) {
-                cout << "\nSearching for pattern '" << pat << "' using "
-                    << algorithms[algoChoice - 1] << "...\n";
-
-                start = chrono::high_resolution_clock::now();
-                switch (algoChoice) {
-                case 1: positions = PatternSearch::kmp(sequence, pat); break;
-                case 2: positions = PatternSearch::boyerMoore(sequence, pat); break;
-                case 3: positions = PatternSearch::rabinKarp(sequence, pat); break;
-                case 4: positions = PatternSearch::naiveSearch(sequence, pat); break;
+                PatternSearch::Algorithm algorithm = static_cast<PatternSearch::Algorithm>(algoChoice - 1);
+                if (degenerate && algorithm != PatternSearch::IUPAC && !PatternSearch::isApproximate(algorithm)) {
+                    cout << "Pattern contains IUPAC degenerate codes.\n";
+                    algorithm = PatternSearch::IUPAC;
                 }
-                end = chrono::high_resolution_clock::now();
-                duration = end - start;
+                algoName = algorithms[algorithm];
+
+                cout << "\nSearching for pattern '" << pat << "' using " << algoName << "...\n";
+
+                if (PatternSearch::isApproximate(algorithm)) {
+                    bool hammingMode = algorithm == PatternSearch::APPROX_HAMMING;
+                    cout << "Maximum " << (hammingMode ? "mismatches" : "edit distance") << ": ";
+                    int maxDistance;
+                    if (!(cin >> maxDistance) || maxDistance < 0) {
+                        cin.clear();
+                        cin.ignore(99999, '\n');
+                        maxDistance = 1;
+                    }
+
+                    vector<ApproxMatch> matches;
+                    double seconds = timeSeconds([&]() {
+                        matches = ApproximateSearch::searchParallel(
+                            hammingMode ? ApproximateSearch::HAMMING : ApproximateSearch::EDIT,
+                            target, ranges, pat, maxDistance, threadCount);
+                    });
+
+                    vector<string> firstHits;
+                    for (size_t i = 0; i < matches.size() && i < 10; i++) {
+                        firstHits.push_back(formatInterval(records, storeOffset + matches[i].start,
+                            storeOffset + matches[i].end) + " (d=" + to_string(matches[i].distance) + ")");
+                    }
+                    printFound(matches.size(), " within distance " + to_string(maxDistance), seconds, firstHits);
 
-                algoName = algorithms[algoChoice - 1];
+                    history.addOperation("Approximate Search", searchDetails(pat, regionLabel, algoName,
+                        ", Max distance: " + to_string(maxDistance), matches.size(), seconds));
+                    break;
+                }
 
-                cout << "\nFound " << positions.size() << " matches in "
-                    << fixed << setprecision(6) << duration.count() << " seconds.\n";
+                if (!ensureIndex(algorithm, indexes, sequence)) break;
+                PatternSearch::Strand strand = selectStrand();
+                const char* strandLabels[] = { "+", "-", "both" };
+
+                cout << "Output: 1) Count and first 10 hits  2) Stop at first hit  3) Write all hits to BED\n";
+                cout << "Choose: ";
+                int outputMode;
+                if (!(cin >> outputMode) || outputMode < 1 || outputMode > 3) {
+                    cin.clear();
+                    cin.ignore(99999, '\n');
+                    outputMode = 1;
+                }
 
-                if (!positions.empty()) {
-                    int toShow = min(10, static_cast<int>(positions.size()));
-                    cout << "First " << toShow << " positions:\n";
-                    for (int i = 0; i < toShow; i++) {
-                        cout << "  " << positions[i] << "\n";
+                size_t found = 0;
+                double seconds = 0;
+                if (outputMode == 3) {
+                    cout << "Enter output filename: ";
+                    string outPath;
+                    cin >> outPath;
+                    BufferedWriter writer(outPath);
+                    if (!writer.isOpen()) {
+                        cout << "Could not open " << outPath << " for writing.\n";
+                        break;
                     }
-                    if (positions.size() > 10) {
-                        cout << "  ... and " << (positions.size() - 10) << " more\n";
+                    BedSink plusSink(writer, records, storeOffset, pat.size(), pat, '+');
+                    BedSink minusSink(writer, records, storeOffset, pat.size(), pat, '-');
+
+                    seconds = timeSeconds([&]() {
+                        runAlgorithmStranded(algorithm, target, ranges, pat, strand, sequence, indexes,
+                            storeOffset, threadCount, plusSink, minusSink);
+                        writer.flush();
+                    });
+
+                    found = plusSink.count + minusSink.count;
+                    cout << "\nWrote " << found << " matches to " << outPath << " in "
+                        << fixed << setprecision(6) << seconds << " seconds.\n";
+                }
+                else {
+                    // Summary keeps only the first 10 hits per strand and counts the rest;
+                    // the existence check stops both strands at their first hit.
+                    bool firstOnly = outputMode == 2;
+                    FirstNSink plusSink(firstOnly ? 1 : 10, !firstOnly);
+                    FirstNSink minusSink(firstOnly ? 1 : 10, !firstOnly);
+
+                    seconds = timeSeconds([&]() {
+                        runAlgorithmStranded(algorithm, target, ranges, pat, strand, sequence, indexes,
+                            storeOffset, threadCount, plusSink, minusSink);
+                    });
+
+                    vector<StrandedMatch> matches = PatternSearch::mergeStrands(plusSink.positions,
+                        minusSink.positions);
+                    found = plusSink.count + minusSink.count;
+
+                    if (firstOnly) {
+                        cout << "\nPattern " << (matches.empty() ? "not found" : "found") << " in "
+                            << fixed << setprecision(6) << seconds << " seconds.\n";
+                        if (!matches.empty()) {
+                            cout << "First hit: " << formatPosition(records, storeOffset + matches[0].position)
+                                << " (" << matches[0].strand << ")\n";
+                        }
+                    }
+                    else {
+                        vector<string> firstHits;
+                        for (size_t i = 0; i < matches.size() && i < 10; i++) {
+                            firstHits.push_back(formatPosition(records, storeOffset + matches[i].position) +
+                                " (" + matches[i].strand + ")");
+                        }
+                        printFound(found, "", seconds, firstHits);
                     }
                 }
 
-                history.addOperation("Pattern Search",
-                    "Pattern: " + pat + ", Algorithm: " + algoName +
-                    ", Found: " + to_string(positions.size()) +
-                    ", Time: " + to_string(duration.count()) + "s");
+                history.addOperation("Pattern Search", searchDetails(pat, regionLabel, algoName,
+                    string(", Strand: ") + strandLabels[strand] + (outputMode == 2 ? ", First hit only" : ""),
+                    found, seconds));
             }
             else if (algoChoice == static_cast<int>(algorithms.size() + 1)) {
                 cout << "\n=== Comparing All Search Algorithms ===\n";
                 cout << "Pattern: '" << pat << "' in sequence of length "
-                    << sequence.size() << "\n\n";
+                    << target.size() << "\n\n";
 
-                vector<pair<string, vector<int>>> results;
+                vector<pair<string, vector<size_t>>> results;
                 vector<pair<string, double>> timings;
-
                 for (size_t i = 0; i < algorithms.size(); i++) {
+                    PatternSearch::Algorithm algorithm = static_cast<PatternSearch::Algorithm>(i);
+                    if (degenerate && algorithm != PatternSearch::IUPAC) continue;
+                    if (!ensureIndex(algorithm, indexes, sequence)) continue;
+
+                    auto collect = [&](unsigned threads, vector<size_t>& positions) {
+                        return timeSeconds([&]() {
+                            if (PatternSearch::isApproximate(algorithm)) {
+                                positions = approximateStarts(algorithm, target, ranges, pat, 0, threads);
+                                return;
+                            }
+                            positions.clear();
+                            VectorSink sink(positions);
+                            runAlgorithm(algorithm, target, ranges, pat, sequence, indexes, storeOffset, threads,
+                                sink);
+                        });
+                    };
+
                     cout << "Running " << algorithms[i] << "...";
                     cout.flush();
 
-                    start = chrono::high_resolution_clock::now();
-                    vector<int> algoPositions;
-                    switch (i) {
-                    case 0: algoPositions = PatternSearch::kmp(sequence, pat); break;
-                    case 1: algoPositions = PatternSearch::boyerMoore(sequence, pat); break;
-                    case 2: algoPositions = PatternSearch::rabinKarp(sequence, pat); break;
-                    case 3: algoPositions = PatternSearch::naiveSearch(sequence, pat); break;
-                    }
-                    end = chrono::high_resolution_clock::now();
-                    duration = end - start;
+                    vector<size_t> positions;
+                    double single = collect(1, positions);
+                    cout << " found " << positions.size() << " matches, "
+                        << fixed << setprecision(6) << single << " seconds";
+                    results.push_back({ algorithms[i], move(positions) });
+                    timings.push_back({ algorithms[i], single });
+
+                    if (threadCount > 1 && !PatternSearch::isIndexed(algorithm)) {
+                        double parallel = collect(threadCount, positions);
 
-                    results.push_back({ algorithms[i], algoPositions });
-                    timings.push_back({ algorithms[i], duration.count() });
+                        string parallelName = algorithms[i] + " [" + to_string(threadCount) + " threads]";
+                        results.push_back({ parallelName, move(positions) });
+                        timings.push_back({ parallelName, parallel });
 
-                    cout << " found " << algoPositions.size() << " matches, "
-                        << fixed << setprecision(6) << duration.count() << " seconds\n";
+                        cout << "; " << threadCount << " threads: " << parallel << " seconds ("
+                            << setprecision(2) << (parallel > 0 ? single / parallel : 0.0) << "x)";
+                    }
+                    cout << "\n";
                 }
 
                 bool consistent = true;
-                size_t expected = results[0].second.size();
                 for (size_t i = 1; i < results.size(); i++) {
-                    if (results[i].second.size() != expected) {
+                    if (results[i].second != results[0].second) {
                         consistent = false;
                         break;
                     }
@@ -203,18 +575,14 @@ void Menu::run(int argc, char* argv[]) {
             else {
                 cout << "Invalid algorithm choice. Using KMP algorithm.\n";
 
-                start = chrono::high_resolution_clock::now();
-                positions = PatternSearch::kmp(sequence, pat);
-                end = chrono::high_resolution_clock::now();
-                duration = end - start;
-
-                cout << "\nFound " << positions.size() << " matches in "
-                    << fixed << setprecision(6) << duration.count() << " seconds.\n";
+                CountSink counter;
+                double seconds = timeSeconds([&]() {
+                    PatternSearch::run(PatternSearch::KMP, target, ranges, pat, counter);
+                });
+                printFound(counter.count, "", seconds, {});
 
                 history.addOperation("Pattern Search",
-                    "Pattern: " + pat + ", Algorithm: KMP" +
-                    ", Found: " + to_string(positions.size()) +
-                    ", Time: " + to_string(duration.count()) + "s");
+                    searchDetails(pat, regionLabel, algorithms[PatternSearch::KMP], "", counter.count, seconds));
             }
             break;
         }
@@ -225,22 +593,60 @@ void Menu::run(int argc, char* argv[]) {
                 break;
             }
 
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+            vector<RecordRange> ranges = SequenceLoader::recordRanges(records, storeOffset, target.size());
+
             cout << "Enter k (recommended: 3-15 for large chromosomes): ";
             int k;
             cin >> k;
 
-            auto kmers = KmerAnalyzer::count(sequence, k);
+            cout << "Count canonical k-mers (merge both strands)? (y/n): ";
+            string strandChoice;
+            cin >> strandChoice;
+            bool canonical = !strandChoice.empty() && (strandChoice[0] == 'y' || strandChoice[0] == 'Y');
+
+            bool dense = KmerAnalyzer::useDense(target.size(), k);
+            bool encoded = !dense && k > 0 && k <= KmerTable::MAX_K;
+            DenseKmerCounts denseCounts;
+            vector<KmerTable> tables;
+            unordered_map<string, int> kmers;
+            if (dense) {
+                denseCounts = KmerAnalyzer::countDense(target, ranges, k, canonical);
+            }
+            else if (encoded) {
+                if (threadCount > 1) tables = KmerAnalyzer::countParallel(target, ranges, k, threadCount, canonical);
+                else tables.push_back(KmerAnalyzer::countEncoded(target, ranges, k, canonical));
+            }
+            else {
+                kmers = KmerAnalyzer::count(target, ranges, k, canonical);
+            }
 
-            if (!kmers.empty()) {
-                cout << "\nTop 10 most frequent " << k << "-mers:\n";
+            size_t distinct = dense ? denseCounts.distinct() : kmers.size();
+            size_t tableBytes = 0;
+            for (const KmerTable& table : tables) {
+                distinct += table.size();
+                tableBytes += table.memoryUsage();
+            }
+            if (distinct > 0) {
+                cout << "\nTop 10 most frequent " << (canonical ? "canonical " : "") << k << "-mers:\n";
 
                 vector<pair<string, int>> top;
-                if (useHeapForKmers) {
-                    top = KmerAnalyzer::topKmersHeap(kmers, 10);
+                if (dense) {
+                    top = KmerAnalyzer::topKmers(denseCounts, 10);
+                    cout << "[Using Dense Array Scan, " << denseCounts.getWidth() * 8 << "-bit counters]\n";
+                }
+                else if (useHeapForKmers) {
+                    top = encoded ? KmerAnalyzer::topKmersHeap(tables, 10)
+                        : KmerAnalyzer::topKmersHeap(kmers, 10);
                     cout << "[Using Heap Algorithm]\n";
                 }
                 else {
-                    top = KmerAnalyzer::topKmers(kmers, 10);
+                    top = encoded ? KmerAnalyzer::topKmers(tables, 10)
+                        : KmerAnalyzer::topKmers(kmers, 10);
                     cout << "[Using Sorting Algorithm]\n";
                 }
 
@@ -249,20 +655,39 @@ void Menu::run(int argc, char* argv[]) {
                         << top[i].first << " : " << top[i].second << " times\n";
                 }
 
-                cout << "\nBuilding K-mer BST for demonstration...\n";
-                KmerBST bst;
-                for (const auto& kmer : kmers) {
-                    bst.insert(kmer.first, kmer.second);
+                if (dense || encoded) {
+                    size_t bytes = dense ? denseCounts.memoryUsage() : tableBytes;
+                    cout << "Distinct " << k << "-mers: " << distinct << " ("
+                        << bytes / (1024.0 * 1024.0) << " MB " << (dense ? "array" : "table") << ")\n";
                 }
-                cout << "BST contains 'ATG': " << (bst.contains("ATG") ? "Yes" : "No") << "\n";
-                if (k >= 3 && bst.contains("ATG")) {
-                    cout << "Count of 'ATG' in BST: " << bst.getCount("ATG") << "\n";
+
+                if (dense || encoded) {
+                    cout << "\nBuilding ordered K-mer index for demonstration...\n";
+                    KmerBST bst;
+                    if (dense) bst.build(denseCounts);
+                    else bst.build(tables);
+
+                    if (k == 3) {
+                        cout << "Index contains 'ATG': " << (bst.contains("ATG") ? "Yes" : "No") << "\n";
+                        if (bst.contains("ATG")) {
+                            cout << "Count of 'ATG' in index: " << bst.getCount("ATG") << "\n";
+                        }
+                    }
+                    else if (k > 3) {
+                        vector<pair<string, int>> withATG = bst.getKmersWithPrefix("ATG");
+                        cout << "K-mers starting with 'ATG': " << withATG.size() << " distinct, "
+                            << bst.countWithPrefix("ATG") << " occurrences\n";
+                        for (size_t i = 0; i < withATG.size() && i < 5; i++) {
+                            cout << "  " << withATG[i].first << " : " << withATG[i].second << "\n";
+                        }
+                    }
                 }
             }
 
             history.addOperation("K-mer Analysis",
-                "k=" + to_string(k) + ", Algorithm=" +
-                (useHeapForKmers ? "Heap" : "Sorting"));
+                "k=" + to_string(k) + ", Region=" + regionLabel + ", Algorithm=" +
+                (dense ? "Dense" : (useHeapForKmers ? "Heap" : "Sorting")) +
+                ", Threads=" + to_string(threadCount) + (canonical ? ", Canonical" : ""));
             break;
         }
 
@@ -272,8 +697,14 @@ void Menu::run(int argc, char* argv[]) {
                 break;
             }
 
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+
             cout << "Calculating GC content...\n";
-            double gc = DNAUtils::gcContent(sequence);
+            double gc = getStats(stats, sequence, records, target, storeOffset, threadCount).gcPercent();
             cout << "\nGC Content: " << fixed << setprecision(2) << gc << "%\n";
 
             if (gc < 40) cout << "(Low GC content)\n";
@@ -290,8 +721,15 @@ void Menu::run(int argc, char* argv[]) {
                 break;
             }
 
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+            vector<RecordRange> ranges = SequenceLoader::recordRanges(records, storeOffset, target.size());
+
             cout << "Searching for SRY marker...\n";
-            bool yes = DNAUtils::containsSRY(sequence);
+            bool yes = DNAUtils::containsSRY(target, ranges);
 
             if (yes) {
                 cout << "\nSRY gene marker found.\nLikely MALE.\n";
@@ -310,33 +748,41 @@ void Menu::run(int argc, char* argv[]) {
                 break;
             }
 
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+
             cout << "\n=== Sequence Information ===\n";
-            cout << "Header: " << header << "\n";
-            cout << "Length: " << sequence.size() << " bp";
-            cout << " (" << sequence.size() / 1000000.0 << " Mbp)\n";
-
-            size_t countA = 0, countC = 0, countG = 0, countT = 0, countN = 0;
-            for (char c : sequence) {
-                switch (c) {
-                case 'A': countA++; break;
-                case 'C': countC++; break;
-                case 'G': countG++; break;
-                case 'T': countT++; break;
-                case 'N': countN++; break;
-                }
+            if (regionLabel == "all") {
+                cout << "Header: " << records.front().header << "\n";
+                cout << "Records: " << records.size() << "\n";
+            }
+            else {
+                cout << "Region: " << regionLabel << "\n";
             }
+            cout << "Length: " << target.size() << " bp";
+            cout << " (" << target.size() / 1000000.0 << " Mbp)\n";
+
+            cout << "Memory: " << target.memoryUsage() / (1024.0 * 1024.0) << " MB (2-bit packed, "
+                << target.getNRuns().size() << " N runs)\n";
+
+            SequenceStats composition = getStats(stats, sequence, records, target, storeOffset, threadCount);
+            const char BASES[5] = { 'A', 'C', 'G', 'T', 'N' };
 
             cout << "\nBase composition:\n";
-            cout << "  A: " << countA << " (" << (countA * 100.0 / sequence.size()) << "%)\n";
-            cout << "  C: " << countC << " (" << (countC * 100.0 / sequence.size()) << "%)\n";
-            cout << "  G: " << countG << " (" << (countG * 100.0 / sequence.size()) << "%)\n";
-            cout << "  T: " << countT << " (" << (countT * 100.0 / sequence.size()) << "%)\n";
-            if (countN > 0) {
-                cout << "  N: " << countN << " (" << (countN * 100.0 / sequence.size()) << "%)\n";
+            for (int b = 0; b < 5; b++) {
+                if (b == 4 && composition.counts[4] == 0) break;
+                cout << "  " << BASES[b] << ": " << composition.counts[b] << " ("
+                    << composition.percent(b) << "%)\n";
+            }
+            if (composition.nRunCount > 0) {
+                cout << "Longest N run: " << composition.longestNRun << " bp\n";
             }
 
             history.addOperation("Sequence Info",
-                "Length: " + to_string(sequence.size()));
+                "Region: " + regionLabel + ", Length: " + to_string(target.size()));
             break;
         }
 
@@ -350,19 +796,26 @@ void Menu::run(int argc, char* argv[]) {
                 break;
             }
 
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+
             cout << "Validating sequence...\n";
-            bool isValid = DNAUtils::isValidDNA(sequence);
-            bool quickValid = DNAUtils::quickValidation(sequence);
-            size_t hash = DNAUtils::sequenceHash(sequence);
+            SequenceStats composition = getStats(stats, sequence, records, target, storeOffset, threadCount);
+            bool isValid = composition.invalidChars == 0;
 
             cout << "\nValidation Results:\n";
-            cout << "Full Validation: " << (isValid ? "VALID" : "INVALID") << "\n";
-            cout << "Quick Validation: " << (quickValid ? "VALID" : "INVALID") << "\n";
-            cout << "Sequence Hash: " << hash << "\n";
+            cout << "Status: " << (isValid ? "VALID" : "INVALID") << "\n";
+            cout << "Invalid characters replaced with N: " << composition.invalidChars;
+            if (&target != &sequence && !isValid) cout << " (in the records this region overlaps)";
+            cout << "\n";
+            cout << "Sequence Hash: " << composition.hash << "\n";
 
             history.addOperation("Sequence Validation",
-                "Full: " + string(isValid ? "Valid" : "Invalid") +
-                ", Quick: " + string(quickValid ? "Valid" : "Invalid"));
+                "Region: " + regionLabel + ", " + string(isValid ? "Valid" : "Invalid") +
+                ", Invalid characters: " + to_string(composition.invalidChars));
             break;
         }
 
@@ -374,7 +827,647 @@ void Menu::run(int argc, char* argv[]) {
                 useHeapForKmers ? "Heap" : "Sorting");
             break;
 
-        case 10:
+        case 10: {
+            cout << "Enter indexed FASTA filename: ";
+            string path;
+            cin >> path;
+            cout << "Enter region (record or record:start-end): ";
+            string region;
+            cin >> region;
+
+            indexes.clear();
+            stats.clear();
+            if (SequenceLoader::fetchRegion(path, region, sequence, records)) {
+                loaded = true;
+                history.addOperation("Load Region", path + " " + region);
+            }
+            break;
+        }
+
+        case 11: {
+            cout << "Current thread count: " << threadCount << "\n";
+            cout << "Enter thread count (0 = all cores): ";
+            int count;
+            if (!(cin >> count) || count < 0) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                cout << "Invalid thread count.\n";
+                break;
+            }
+
+            threadCount = (count == 0) ? max(1u, thread::hardware_concurrency())
+                : static_cast<unsigned>(count);
+            cout << "Thread count set to: " << threadCount << "\n";
+            history.addOperation("Set Threads", to_string(threadCount));
+            break;
+        }
+
+        case 12: {
+            if (!loaded) {
+                cout << "Please load a FASTA first.\n";
+                break;
+            }
+
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+            vector<RecordRange> ranges = SequenceLoader::recordRanges(records, storeOffset, target.size());
+
+            cout << "Enter k (1-32): ";
+            int k;
+            cin >> k;
+            cout << "Enter memory budget in MB: ";
+            size_t budgetMB;
+            if (!(cin >> budgetMB) || budgetMB == 0) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                budgetMB = 64;
+            }
+            cout << "Run exact second pass over candidates? (y/n): ";
+            string exactChoice;
+            cin >> exactChoice;
+            bool exactPass = !exactChoice.empty() && (exactChoice[0] == 'y' || exactChoice[0] == 'Y');
+            cout << "Count canonical k-mers (merge both strands)? (y/n): ";
+            string strandChoice;
+            cin >> strandChoice;
+            bool canonical = !strandChoice.empty() && (strandChoice[0] == 'y' || strandChoice[0] == 'Y');
+
+            auto start = chrono::high_resolution_clock::now();
+            vector<HeavyHitter> top = KmerAnalyzer::topKmersBounded(target, ranges, k, 10,
+                budgetMB * 1024 * 1024, exactPass, canonical);
+            chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+
+            if (top.empty()) {
+                cout << "No k-mers found (k must be between 1 and 32).\n";
+                break;
+            }
+
+            cout << "\nTop " << top.size() << (exactPass ? " (exact counts)" : " (approximate counts)")
+                << " " << k << "-mers using " << budgetMB << " MB:\n";
+            for (size_t i = 0; i < top.size(); i++) {
+                cout << setw(3) << (i + 1) << ". " << KmerTable::decode(top[i].code, k)
+                    << " : " << top[i].count;
+                if (!exactPass) {
+                    cout << " (true count in [" << (top[i].count - top[i].error)
+                        << ", " << top[i].count << "])";
+                }
+                cout << "\n";
+            }
+            cout << "Time: " << fixed << setprecision(6) << duration.count() << " seconds\n";
+
+            history.addOperation("Heavy-Hitter K-mers",
+                "k=" + to_string(k) + ", Region=" + regionLabel + ", Budget=" + to_string(budgetMB) +
+                "MB" + (exactPass ? ", Exact" : ", Approximate"));
+            break;
+        }
+
+        case 13: {
+            if (!loaded) {
+                cout << "Please load a FASTA first.\n";
+                break;
+            }
+
+            cout << "Index type: 1) Suffix array  2) FM-index\n";
+            cout << "Choose: ";
+            int type;
+            if (!(cin >> type) || (type != 1 && type != 2)) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                cout << "Invalid option.\n";
+                break;
+            }
+            bool useFM = type == 2;
+            string indexName = useFM ? "FM-Index" : "Suffix Array";
+
+            cout << "1) Build index\n";
+            cout << "2) Save index to file\n";
+            cout << "3) Load (map) index from file\n";
+            cout << "Choose: ";
+            int action;
+            if (!(cin >> action)) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                break;
+            }
+
+            if (action == 1) {
+                if (useFM) {
+                    cout << "SA sample rate (higher = smaller index, slower locate) ["
+                        << indexes.fmSampleRate << "]: ";
+                    unsigned rate;
+                    if (cin >> rate && rate > 0) {
+                        indexes.fmSampleRate = rate;
+                    }
+                    else {
+                        cin.clear();
+                        cin.ignore(99999, '\n');
+                    }
+                    indexes.fm.clear();
+                    if (!ensureFMIndex(indexes, sequence)) break;
+                    history.addOperation("Build FM-Index", "Sample rate: " + to_string(indexes.fmSampleRate) +
+                        ", Size: " + to_string(indexes.fm.memoryUsage()) + " bytes");
+                }
+                else {
+                    indexes.suffixArray.clear();
+                    if (!ensureSuffixArray(indexes, sequence)) break;
+                    size_t repeatPos = 0;
+                    size_t repeatLen = indexes.suffixArray.longestRepeat(repeatPos);
+                    if (repeatLen > 0) {
+                        cout << "Longest repeat: " << repeatLen << " bp at "
+                            << formatPosition(records, repeatPos) << "\n";
+                    }
+                    history.addOperation("Build Suffix Array",
+                        to_string(indexes.suffixArray.size()) + " suffixes");
+                }
+            }
+            else if (action == 2) {
+                if (!ensureIndex(useFM ? PatternSearch::FM_INDEX : PatternSearch::SUFFIX_ARRAY, indexes, sequence)) break;
+                cout << "Enter index filename: ";
+                string path;
+                cin >> path;
+                bool saved = useFM ? indexes.fm.save(path) : indexes.suffixArray.save(path);
+                if (saved) {
+                    cout << "Index saved to " << path << "\n";
+                    history.addOperation("Save " + indexName, path);
+                }
+            }
+            else if (action == 3) {
+                cout << "Enter index filename: ";
+                string path;
+                cin >> path;
+                bool mappedOk = useFM ? indexes.fm.load(path) : indexes.suffixArray.load(path);
+                if (!mappedOk) break;
+                bool matching = useFM ? indexes.fm.matches(sequence) : indexes.suffixArray.matches(sequence);
+                if (!matching) {
+                    cout << "Index was built from a different sequence; discarding it.\n";
+                    if (useFM) indexes.fm.clear();
+                    else indexes.suffixArray.clear();
+                    break;
+                }
+                if (useFM) {
+                    indexes.fmSampleRate = indexes.fm.getSampleRate();
+                    cout << "Mapped FM-index over " << indexes.fm.size() << " bases (sample rate "
+                        << indexes.fm.getSampleRate() << ")\n";
+                }
+                else {
+                    cout << "Mapped index with " << indexes.suffixArray.size() << " suffixes"
+                        << (indexes.suffixArray.hasLcp() ? " and LCP array" : "") << "\n";
+                }
+                history.addOperation("Load " + indexName, path);
+            }
+            else {
+                cout << "Invalid option.\n";
+            }
+            break;
+        }
+
+        case 14: {
+            if (!loaded) {
+                cout << "Please load a FASTA first.\n";
+                break;
+            }
+
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+            vector<RecordRange> ranges = SequenceLoader::recordRanges(records, storeOffset, target.size());
+
+            cout << "Enter motif file (one motif per line, optional name first): ";
+            string motifPath;
+            cin >> motifPath;
+
+            AhoCorasick automaton;
+            size_t skipped = 0;
+            if (!AhoCorasick::loadMotifs(motifPath, automaton, skipped)) {
+                cout << "No usable motifs loaded.\n";
+                break;
+            }
+            cout << "Loaded " << automaton.patternCount() << " motifs";
+            if (skipped > 0) cout << ", skipped " << skipped << " with non-ACGT characters";
+            cout << "\n";
+
+            cout << "1) Summary per motif\n";
+            cout << "2) Write every match to a BED file\n";
+            cout << "3) Fingerprint screen of equal-length probes (Rabin-Karp)\n";
+            cout << "Choose: ";
+            int mode;
+            if (!(cin >> mode)) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                mode = 1;
+            }
+
+            // Both strands share one automaton, so they cost a single scan.
+            PatternSearch::Strand strand = PatternSearch::PLUS_STRAND;
+            const char* strandLabels[] = { "+", "-", "both" };
+            if (mode != 3) {
+                strand = selectStrand();
+                automaton.build(strand != PatternSearch::MINUS_STRAND, strand != PatternSearch::PLUS_STRAND);
+                cout << "Automaton: " << automaton.stateCount() << " states\n";
+            }
+
+            size_t totalMatches = 0;
+            auto start = chrono::high_resolution_clock::now();
+            if (mode == 2) {
+                cout << "Enter output filename: ";
+                string outPath;
+                cin >> outPath;
+                BufferedWriter out(outPath);
+                if (!out.isOpen()) {
+                    cout << "Could not open " << outPath << " for writing.\n";
+                    break;
+                }
+
+                // Hits arrive by end position and never span two records, so
+                // their records only move forward, as in BedSink.
+                size_t record = SequenceLoader::findRecord(records, storeOffset);
+                automaton.scan(target, ranges, [&](size_t pos, size_t motif, char motifStrand) {
+                    size_t storePos = storeOffset + pos;
+                    while (record + 1 < records.size() && records[record + 1].offset <= storePos) record++;
+
+                    const FastaRecord& r = records[record];
+                    size_t recordPos = storePos - r.offset + r.start;
+                    const Motif& m = automaton.getMotif(motif);
+                    out.append(r.name);
+                    out.append('\t');
+                    out.append(recordPos);
+                    out.append('\t');
+                    out.append(recordPos + m.pattern.size());
+                    out.append('\t');
+                    out.append(m.name);
+                    out.append("\t0\t", 3);
+                    out.append(motifStrand);
+                    out.append('\n');
+                    totalMatches++;
+                });
+                out.flush();
+                cout << "Wrote " << totalMatches << " matches to " << outPath << "\n";
+            }
+            else if (mode == 3) {
+                RabinKarp probes;
+                size_t rejected = 0;
+                for (size_t i = 0; i < automaton.patternCount(); i++) {
+                    const Motif& m = automaton.getMotif(i);
+                    if (!probes.addProbe(m.pattern, m.name)) rejected++;
+                }
+                if (rejected > 0) {
+                    cout << "Skipped " << rejected << " probes not of length " << probes.probeLength() << "\n";
+                }
+
+                ScreenStats stats;
+                vector<size_t> counts = probes.countMatches(target, ranges, stats);
+                totalMatches = stats.matches;
+
+                size_t hitProbes = 0;
+                for (size_t count : counts) hitProbes += count > 0 ? 1 : 0;
+                cout << "\n" << hitProbes << " of " << probes.probeCount() << " probes ("
+                    << probes.probeLength() << " bp) found, " << totalMatches << " matches\n";
+                for (size_t i = 0, shown = 0; i < counts.size() && shown < 20; i++) {
+                    if (counts[i] == 0) continue;
+                    cout << "  " << probes.getName(i) << " : " << counts[i] << "\n";
+                    shown++;
+                }
+
+                cout << "Windows fingerprinted: " << stats.windows << "\n";
+                cout << "Fingerprint hits: " << stats.candidates << ", collisions: " << stats.collisions
+                    << " (rate " << scientific << setprecision(2)
+                    << (stats.windows > 0 ? static_cast<double>(stats.collisions) / stats.windows : 0.0)
+                    << ")\n" << defaultfloat;
+                cout << "Verification cost: " << stats.basesCompared << " bases compared ("
+                    << fixed << setprecision(3)
+                    << (stats.windows > 0 ? static_cast<double>(stats.basesCompared) / stats.windows : 0.0)
+                    << " per window)\n";
+            }
+            else {
+                vector<size_t> counts = automaton.countMatches(target, ranges);
+                vector<size_t> order(counts.size());
+                for (size_t i = 0; i < order.size(); i++) {
+                    order[i] = i;
+                    totalMatches += counts[i];
+                }
+                sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                    return counts[a] > counts[b];
+                });
+
+                size_t toShow = min<size_t>(20, order.size());
+                cout << "\nTop " << toShow << " motifs by occurrence:\n";
+                for (size_t i = 0; i < toShow; i++) {
+                    const Motif& m = automaton.getMotif(order[i]);
+                    cout << setw(3) << (i + 1) << ". " << m.name;
+                    if (m.name != m.pattern) cout << " (" << m.pattern << ")";
+                    cout << " : " << counts[order[i]] << "\n";
+                }
+                cout << "Total matches: " << totalMatches << "\n";
+            }
+            chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+            cout << "Scan time: " << fixed << setprecision(6) << duration.count() << " seconds\n";
+
+            history.addOperation("Motif Scan",
+                motifPath + ", Motifs: " + to_string(automaton.patternCount()) + ", Region: " +
+                regionLabel + (mode != 3 ? string(", Strand: ") + strandLabels[strand] : string()) +
+                ", Matches: " + to_string(totalMatches));
+            break;
+        }
+
+        case 15: {
+            if (!loaded) {
+                cout << "Please load a FASTA first.\n";
+                break;
+            }
+
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+
+            size_t window = 0, step = 0;
+            cout << "Window size (bp): ";
+            if (!(cin >> window) || window == 0) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                cout << "Invalid window size.\n";
+                break;
+            }
+            cout << "Step (bp): ";
+            if (!(cin >> step) || step == 0) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                cout << "Invalid step.\n";
+                break;
+            }
+
+            cout << "Track: 1) GC%  2) GC skew  3) Both\n";
+            cout << "Choose: ";
+            int track;
+            if (!(cin >> track) || track < 1 || track > 3) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                track = 1;
+            }
+            cout << "Format: 1) bedGraph  2) WIG\n";
+            cout << "Choose: ";
+            int formatChoice;
+            if (!(cin >> formatChoice) || formatChoice < 1 || formatChoice > 2) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                formatChoice = 1;
+            }
+            GcProfile::Format format = formatChoice == 2 ? GcProfile::WIG : GcProfile::BEDGRAPH;
+            string extension = format == GcProfile::WIG ? ".wig" : ".bedgraph";
+
+            cout << "Output file prefix: ";
+            string prefix;
+            cin >> prefix;
+
+            unique_ptr<BufferedWriter> gcOut, skewOut;
+            if (track != 2) gcOut = make_unique<BufferedWriter>(prefix + ".gc" + extension);
+            if (track != 1) skewOut = make_unique<BufferedWriter>(prefix + ".skew" + extension);
+            if ((gcOut && !gcOut->isOpen()) || (skewOut && !skewOut->isOpen())) {
+                cout << "Could not open output files with prefix " << prefix << ".\n";
+                break;
+            }
+
+            auto start = chrono::high_resolution_clock::now();
+            size_t windows = GcProfile::write(target, records, storeOffset, window, step, format,
+                gcOut.get(), skewOut.get(), threadCount);
+            if (gcOut) gcOut->flush();
+            if (skewOut) skewOut->flush();
+            chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+
+            cout << "Wrote " << windows << " windows";
+            if (gcOut) cout << " to " << prefix << ".gc" << extension;
+            if (skewOut) cout << (gcOut ? " and " : " to ") << prefix << ".skew" << extension;
+            cout << "\nTime: " << fixed << setprecision(3) << duration.count() << " seconds\n";
+
+            history.addOperation("GC Profile",
+                "Region: " + regionLabel + ", Window: " + to_string(window) + ", Step: " +
+                to_string(step) + ", Windows: " + to_string(windows));
+            break;
+        }
+
+        case 16: {
+            if (!loaded) {
+                cout << "Please load a FASTA first.\n";
+                break;
+            }
+
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+
+            CpGIslandParams params;
+            cout << "Use Gardiner-Garden thresholds (window 200, length 200, GC 50%, O/E 0.6)? (y/n): ";
+            string defaultsChoice;
+            cin >> defaultsChoice;
+            if (defaultsChoice.empty() || (defaultsChoice[0] != 'y' && defaultsChoice[0] != 'Y')) {
+                cout << "Window size (bp): ";
+                cin >> params.window;
+                cout << "Minimum island length (bp): ";
+                cin >> params.minLength;
+                cout << "Minimum GC%: ";
+                cin >> params.minGcPercent;
+                cout << "Minimum observed/expected CpG: ";
+                cin >> params.minObsExp;
+                if (!cin || params.window < 2) {
+                    cin.clear();
+                    cin.ignore(99999, '\n');
+                    cout << "Invalid thresholds.\n";
+                    break;
+                }
+            }
+
+            cout << "Enter output BED filename: ";
+            string outPath;
+            cin >> outPath;
+            BufferedWriter out(outPath);
+            if (!out.isOpen()) {
+                cout << "Could not open " << outPath << " for writing.\n";
+                break;
+            }
+
+            auto start = chrono::high_resolution_clock::now();
+            vector<CpGIsland> islands = CpGIslands::find(target,
+                SequenceLoader::recordRanges(records, storeOffset, target.size()), params, threadCount);
+            CpGIslands::writeBed(islands, records, storeOffset, out);
+            out.flush();
+            chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+
+            size_t covered = 0;
+            for (const CpGIsland& island : islands) covered += island.length();
+            cout << "\nFound " << islands.size() << " CpG islands covering " << covered << " bp\n";
+            for (size_t i = 0; i < islands.size() && i < 10; i++) {
+                cout << "  " << formatInterval(records, storeOffset + islands[i].start,
+                    storeOffset + islands[i].end) << "  GC " << fixed << setprecision(1)
+                    << islands[i].gcPercent() << "%, O/E " << setprecision(2) << islands[i].obsExp() << "\n";
+            }
+            cout << "Wrote " << outPath << "\n";
+            cout << "Time: " << fixed << setprecision(3) << duration.count() << " seconds\n";
+
+            history.addOperation("CpG Islands",
+                "Region: " + regionLabel + ", Islands: " + to_string(islands.size()));
+            break;
+        }
+
+        case 17: {
+            if (!loaded) {
+                cout << "Please load a FASTA first.\n";
+                break;
+            }
+
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+
+            OrfParams params;
+            cout << "Start codons, comma-separated (or 'default' for ATG): ";
+            string startList;
+            cin >> startList;
+            if (startList != "default" && !OrfFinder::parseCodons(startList, params.startCodons)) {
+                cout << "Invalid codon list.\n";
+                break;
+            }
+            cout << "Stop codons, comma-separated (or 'default' for TAA,TAG,TGA): ";
+            string stopList;
+            cin >> stopList;
+            if (stopList != "default" && !OrfFinder::parseCodons(stopList, params.stopCodons)) {
+                cout << "Invalid codon list.\n";
+                break;
+            }
+            cout << "Minimum ORF length in nucleotides, stop included: ";
+            if (!(cin >> params.minLength) || params.minLength < 6) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                params.minLength = 300;
+                cout << "Using 300.\n";
+            }
+
+            cout << "Format: 1) BED  2) GFF3\n";
+            cout << "Choose: ";
+            int formatChoice;
+            if (!(cin >> formatChoice) || formatChoice < 1 || formatChoice > 2) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                formatChoice = 1;
+            }
+            cout << "Enter output filename: ";
+            string outPath;
+            cin >> outPath;
+            BufferedWriter out(outPath);
+            if (!out.isOpen()) {
+                cout << "Could not open " << outPath << " for writing.\n";
+                break;
+            }
+
+            auto start = chrono::high_resolution_clock::now();
+            vector<Orf> orfs = OrfFinder::find(target,
+                SequenceLoader::recordRanges(records, storeOffset, target.size()), params, threadCount);
+            OrfFinder::write(orfs, records, storeOffset,
+                formatChoice == 2 ? OrfFinder::GFF : OrfFinder::BED, out);
+            out.flush();
+            chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+
+            size_t perFrame[6] = {};
+            size_t longest = 0;
+            for (const Orf& orf : orfs) {
+                perFrame[orf.frame > 0 ? orf.frame - 1 : 2 - orf.frame]++;
+                longest = max(longest, orf.end - orf.start);
+            }
+            cout << "\nFound " << orfs.size() << " ORFs (longest " << longest << " bp)\n";
+            for (int f = 0; f < 6; f++) {
+                cout << "  Frame " << (f < 3 ? "+" : "-") << (f % 3 + 1) << ": " << perFrame[f] << "\n";
+            }
+            cout << "Wrote " << outPath << "\n";
+            cout << "Time: " << fixed << setprecision(3) << duration.count() << " seconds\n";
+
+            history.addOperation("ORF Finder",
+                "Region: " + regionLabel + ", Min length: " + to_string(params.minLength) +
+                ", ORFs: " + to_string(orfs.size()));
+            break;
+        }
+
+        case 18: {
+            if (!loaded) {
+                cout << "Please load a FASTA first.\n";
+                break;
+            }
+
+            PackedSequence regionSeq;
+            size_t storeOffset = 0;
+            string regionLabel;
+            const PackedSequence& target = selectRegion(sequence, records, regionSeq,
+                storeOffset, regionLabel);
+
+            TandemRepeatParams params;
+            cout << "Maximum period (1-" << TandemRepeats::MAX_PERIOD << ", microsatellites use 6): ";
+            if (!(cin >> params.maxPeriod) || params.maxPeriod < 1 ||
+                params.maxPeriod > TandemRepeats::MAX_PERIOD) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                params.maxPeriod = 6;
+                cout << "Using 6.\n";
+            }
+            cout << "Minimum copy number: ";
+            if (!(cin >> params.minCopies) || params.minCopies < 1) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                params.minCopies = 3.0;
+                cout << "Using 3.\n";
+            }
+            cout << "Minimum score (+2 match, -7 mismatch): ";
+            if (!(cin >> params.minScore)) {
+                cin.clear();
+                cin.ignore(99999, '\n');
+                params.minScore = 30;
+                cout << "Using 30.\n";
+            }
+
+            cout << "Enter output filename: ";
+            string outPath;
+            cin >> outPath;
+            BufferedWriter out(outPath);
+            if (!out.isOpen()) {
+                cout << "Could not open " << outPath << " for writing.\n";
+                break;
+            }
+            out.append(string("#chrom\tstart\tend\tunit\tperiod\tcopies\tpurity\tscore\n"));
+
+            vector<size_t> perPeriod(params.maxPeriod + 1, 0);
+            size_t covered = 0;
+            auto start = chrono::high_resolution_clock::now();
+            TandemRepeats finder(target, SequenceLoader::recordRanges(records, storeOffset, target.size()),
+                params, threadCount);
+            size_t total = finder.scan([&](const TandemRepeat& repeat) {
+                TandemRepeats::writeLine(repeat, records, storeOffset, out);
+                perPeriod[repeat.period]++;
+                covered += repeat.length();
+            });
+            out.flush();
+            chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+
+            cout << "\nFound " << total << " tandem repeats covering " << covered << " bp\n";
+            for (unsigned period = 1; period <= params.maxPeriod; period++) {
+                if (perPeriod[period] == 0) continue;
+                cout << "  Period " << period << ": " << perPeriod[period] << "\n";
+            }
+            cout << "Wrote " << outPath << "\n";
+            cout << "Time: " << fixed << setprecision(3) << duration.count() << " seconds\n";
+
+            history.addOperation("Tandem Repeats",
+                "Region: " + regionLabel + ", Max period: " + to_string(params.maxPeriod) +
+                ", Repeats: " + to_string(total));
+            break;
+        }
+
+        case 19:
             cout << "Goodbye!\n";
             return;
 
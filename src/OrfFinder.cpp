@@ -0,0 +1,338 @@
+#include "OrfFinder.h"
+#include "PackedSequence.h"
+#include "SequenceLoader.h"
+#include "MatchSink.h"
+#include "ParallelJobs.h"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <sstream>
+
+using namespace std;
+
+static const size_t CHUNK_BASES = 3 << 21;
+static const size_t NONE = SIZE_MAX;
+static const uint64_t LOW_BITS = 0x5555555555555555ULL;
+
+enum CodonEvent { START, STOP, BREAK };
+
+struct Codon {
+    uint8_t base[3];
+};
+
+// Lane k of the result is set (bit 2k) where the 2-bit lane of x equals b.
+static uint64_t laneEquals(uint64_t x, uint8_t b) {
+    uint64_t y = x ^ (LOW_BITS * b);
+    return ~(y | (y >> 1)) & LOW_BITS;
+}
+
+static bool toCodon(const string& text, Codon& codon) {
+    if (text.size() != 3) return false;
+    for (int i = 0; i < 3; i++) {
+        switch (text[i]) {
+        case 'A': case 'a': codon.base[i] = 0; break;
+        case 'C': case 'c': codon.base[i] = 1; break;
+        case 'G': case 'g': codon.base[i] = 2; break;
+        case 'T': case 't': codon.base[i] = 3; break;
+        default: return false;
+        }
+    }
+    return true;
+}
+
+bool OrfFinder::parseCodons(const string& list, vector<string>& out) {
+    vector<string> codons;
+    stringstream ss(list);
+    string item;
+    while (getline(ss, item, ',')) {
+        Codon codon;
+        if (!toCodon(item, codon)) return false;
+        for (char& c : item) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        codons.push_back(item);
+    }
+    if (codons.empty()) return false;
+    out = codons;
+    return true;
+}
+
+struct ScanJob {
+    size_t range;
+    size_t begin;       // first codon start
+    size_t end;         // last codon start + 1
+};
+
+// One strand and frame of a chunk. head* describe the stretch before the first
+// stop or N codon, which depends on earlier chunks; open/lastStop are the state
+// after the last one.
+struct FrameState {
+    bool terminated = false;
+    size_t headStart = NONE;    // plus: first start before the terminator; minus: last
+    size_t headEnd = NONE;
+    bool headIsStop = false;
+    size_t open = NONE;         // plus: first start since the last terminator; minus: last start since lastStop
+    size_t lastStop = NONE;     // minus strand only
+};
+
+struct JobResult {
+    FrameState plus[3];
+    FrameState minus[3];
+    vector<Orf> orfs;
+};
+
+struct OrfScanner {
+    const RecordRange& range;
+    size_t minLength;
+    JobResult& result;
+
+    void emit(size_t start, size_t end, bool forward) {
+        if (end - start < minLength) return;
+        int frame = forward ? static_cast<int>((start - range.begin) % 3) + 1
+            : -static_cast<int>((range.end - end) % 3) - 1;
+        result.orfs.push_back({ range.record, start, end, frame });
+    }
+
+    void plusEvent(FrameState& f, size_t pos, CodonEvent event) {
+        if (!f.terminated) {
+            if (event == START) {
+                if (f.headStart == NONE) f.headStart = pos;
+                return;
+            }
+            f.terminated = true;
+            f.headEnd = pos;
+            f.headIsStop = event == STOP;
+            return;
+        }
+        if (event == START) {
+            if (f.open == NONE) f.open = pos;
+            return;
+        }
+        if (event == STOP && f.open != NONE) emit(f.open, pos + 3, true);
+        f.open = NONE;
+    }
+
+    // Read right to left, a minus-strand ORF runs from a start codon down to the
+    // nearest stop below it; the longest uses the last start before the next stop.
+    void minusEvent(FrameState& f, size_t pos, CodonEvent event) {
+        if (!f.terminated) {
+            if (event == START) {
+                f.headStart = pos;
+                return;
+            }
+            f.terminated = true;
+            f.headEnd = pos;
+            f.headIsStop = event == STOP;
+            f.lastStop = event == STOP ? pos : NONE;
+            return;
+        }
+        if (event == START) {
+            if (f.lastStop != NONE) f.open = pos;
+            return;
+        }
+        if (f.lastStop != NONE && f.open != NONE) emit(f.lastStop, f.open + 3, false);
+        f.lastStop = event == STOP ? pos : NONE;
+        f.open = NONE;
+    }
+};
+
+// Lane k set where the codon at p + k has an N.
+static uint64_t nLanes(const PackedSequence& seq, size_t p) {
+    uint64_t bases = 0;
+    for (size_t i = 0; i < PackedSequence::BASES_PER_WORD + 2 && p + i < seq.size(); i++) {
+        if (seq.isN(p + i)) bases |= 1ULL << i;
+    }
+    bases |= (bases >> 1) | (bases >> 2);
+
+    uint64_t lanes = 0;
+    for (size_t k = 0; k < PackedSequence::BASES_PER_WORD; k++) {
+        if ((bases >> k) & 1) lanes |= 1ULL << (2 * k);
+    }
+    return lanes;
+}
+
+static void scanJob(const PackedSequence& seq, const RecordRange& range, const ScanJob& job,
+    const vector<Codon>& starts, const vector<Codon>& stops, size_t minLength, JobResult& result)
+{
+    OrfScanner scanner{ range, minLength, result };
+    const size_t block = PackedSequence::BASES_PER_WORD;
+
+    for (size_t p = job.begin; p < job.end; p += block) {
+        uint64_t x0 = seq.wordAt(p);
+        uint64_t x1 = p + block < seq.size() ? seq.wordAt(p + block) : 0;
+        uint64_t shifted[3] = { x0, (x0 >> 2) | (x1 << 62), (x0 >> 4) | (x1 << 60) };
+
+        uint64_t eq[3][4];
+        for (int d = 0; d < 3; d++) {
+            for (uint8_t b = 0; b < 4; b++) eq[d][b] = laneEquals(shifted[d], b);
+        }
+
+        uint64_t startPlus = 0, stopPlus = 0, startMinus = 0, stopMinus = 0;
+        for (const Codon& c : starts) {
+            startPlus |= eq[0][c.base[0]] & eq[1][c.base[1]] & eq[2][c.base[2]];
+            startMinus |= eq[2][3 - c.base[0]] & eq[1][3 - c.base[1]] & eq[0][3 - c.base[2]];
+        }
+        for (const Codon& c : stops) {
+            stopPlus |= eq[0][c.base[0]] & eq[1][c.base[1]] & eq[2][c.base[2]];
+            stopMinus |= eq[2][3 - c.base[0]] & eq[1][3 - c.base[1]] & eq[0][3 - c.base[2]];
+        }
+
+        size_t lanes = min(block, job.end - p);
+        uint64_t laneMask = lanes == block ? ~0ULL : (1ULL << (2 * lanes)) - 1;
+        uint64_t breaks = 0;
+        size_t w = p / block;
+        size_t lastWord = min(seq.wordCount() - 1, (p + block + 1) / block);
+        for (size_t i = w; i <= lastWord; i++) {
+            if (seq.wordHasN(i)) {
+                breaks = nLanes(seq, p);
+                break;
+            }
+        }
+
+        size_t frameBase = (p - range.begin) % 3;
+        for (int strand = 0; strand < 2; strand++) {
+            uint64_t startBits = strand == 0 ? startPlus : startMinus;
+            uint64_t stopBits = strand == 0 ? stopPlus : stopMinus;
+            FrameState* frames = strand == 0 ? result.plus : result.minus;
+
+            uint64_t events = (startBits | stopBits | breaks) & laneMask;
+            while (events != 0) {
+                unsigned bit = static_cast<unsigned>(countr_zero(events));
+                events &= events - 1;
+                uint64_t laneBit = 1ULL << bit;
+                CodonEvent event = (breaks & laneBit) ? BREAK : (stopBits & laneBit) ? STOP : START;
+
+                size_t k = bit / 2;
+                FrameState& f = frames[(frameBase + k) % 3];
+                if (strand == 0) scanner.plusEvent(f, p + k, event);
+                else scanner.minusEvent(f, p + k, event);
+            }
+        }
+    }
+}
+
+vector<Orf> OrfFinder::find(const PackedSequence& seq, const vector<RecordRange>& ranges,
+    const OrfParams& params, unsigned threadCount)
+{
+    vector<Orf> orfs;
+    vector<Codon> starts, stops;
+    for (const string& text : params.startCodons) {
+        Codon codon;
+        if (!toCodon(text, codon)) return orfs;
+        starts.push_back(codon);
+    }
+    for (const string& text : params.stopCodons) {
+        Codon codon;
+        if (!toCodon(text, codon)) return orfs;
+        stops.push_back(codon);
+    }
+
+    // Chunk starts stay a multiple of 3 from the range start so frames line up.
+    vector<ScanJob> jobs;
+    for (size_t r = 0; r < ranges.size(); r++) {
+        if (ranges[r].end - ranges[r].begin < 3) continue;
+        size_t lastStart = ranges[r].end - 2;
+        for (size_t begin = ranges[r].begin; begin < lastStart; begin += CHUNK_BASES) {
+            jobs.push_back({ r, begin, min(lastStart, begin + CHUNK_BASES) });
+        }
+    }
+
+    vector<JobResult> results(jobs.size());
+    ParallelJobs::run(0, jobs.size(), threadCount, [&](size_t j) {
+        scanJob(seq, ranges[jobs[j].range], jobs[j], starts, stops, params.minLength, results[j]);
+    });
+
+    // Carry each frame's open ORF from chunk to chunk within a range.
+    FrameState carryPlus[3], carryMinus[3];
+    for (size_t j = 0; j < jobs.size(); j++) {
+        const RecordRange& range = ranges[jobs[j].range];
+        if (j == 0 || jobs[j].range != jobs[j - 1].range) {
+            for (int f = 0; f < 3; f++) carryPlus[f] = carryMinus[f] = FrameState();
+        }
+        JobResult& result = results[j];
+        OrfScanner scanner{ range, params.minLength, result };
+
+        for (int f = 0; f < 3; f++) {
+            const FrameState& local = result.plus[f];
+            FrameState& carry = carryPlus[f];
+            if (!local.terminated) {
+                if (carry.open == NONE) carry.open = local.headStart;
+                continue;
+            }
+            size_t start = carry.open != NONE ? carry.open : local.headStart;
+            if (local.headIsStop && start != NONE) scanner.emit(start, local.headEnd + 3, true);
+            carry.open = local.open;
+        }
+        for (int f = 0; f < 3; f++) {
+            const FrameState& local = result.minus[f];
+            FrameState& carry = carryMinus[f];
+            if (!local.terminated) {
+                if (local.headStart != NONE && carry.lastStop != NONE) carry.open = local.headStart;
+                continue;
+            }
+            size_t start = local.headStart != NONE ? local.headStart : carry.open;
+            if (carry.lastStop != NONE && start != NONE) scanner.emit(carry.lastStop, start + 3, false);
+            carry.lastStop = local.lastStop;
+            carry.open = local.open;
+        }
+
+        // A minus-strand ORF needs no terminator above its start codon.
+        if (j + 1 == jobs.size() || jobs[j + 1].range != jobs[j].range) {
+            for (int f = 0; f < 3; f++) {
+                if (carryMinus[f].lastStop != NONE && carryMinus[f].open != NONE) {
+                    scanner.emit(carryMinus[f].lastStop, carryMinus[f].open + 3, false);
+                }
+            }
+        }
+
+        orfs.insert(orfs.end(), result.orfs.begin(), result.orfs.end());
+        vector<Orf>().swap(result.orfs);
+    }
+
+    sort(orfs.begin(), orfs.end(), [](const Orf& a, const Orf& b) {
+        if (a.start != b.start) return a.start < b.start;
+        if (a.end != b.end) return a.end < b.end;
+        return a.frame > b.frame;
+    });
+    return orfs;
+}
+
+void OrfFinder::write(const vector<Orf>& orfs, const vector<FastaRecord>& records,
+    size_t storeOffset, Format format, BufferedWriter& out)
+{
+    if (format == GFF) out.append("##gff-version 3\n");
+
+    size_t id = 0;
+    for (const Orf& orf : orfs) {
+        const FastaRecord& record = records[orf.record];
+        size_t start = storeOffset + orf.start - record.offset + record.start;
+        size_t end = start + (orf.end - orf.start);
+        string frame = (orf.frame > 0 ? "+" : "") + to_string(orf.frame);
+        id++;
+
+        out.append(record.name);
+        out.append('\t');
+        if (format == GFF) {
+            out.append(string("DNAAnalyzer\tORF\t"));
+            out.append(start + 1);
+            out.append('\t');
+            out.append(end);
+            out.append("\t.\t", 3);
+            out.append(orf.strand());
+            out.append(string("\t0\tID=orf"));
+            out.append(id);
+            out.append(";frame=" + frame + ";length_aa=");
+            out.append((end - start) / 3 - 1);
+        }
+        else {
+            out.append(start);
+            out.append('\t');
+            out.append(end);
+            out.append("\torf", 4);
+            out.append(id);
+            out.append('_');
+            out.append(frame);
+            out.append("\t0\t", 3);
+            out.append(orf.strand());
+        }
+        out.append('\n');
+    }
+}
\ No newline at end of file
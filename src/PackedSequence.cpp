@@ -0,0 +1,275 @@
+#include "PackedSequence.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+PackedSequence::PackedSequence() : length(0) {}
+
+PackedSequence::PackedSequence(const string& seq) : length(0) {
+    reserve(seq.size());
+    append(seq);
+}
+
+void PackedSequence::clear() {
+    words.clear();
+    nBlocks.clear();
+    nRuns.clear();
+    length = 0;
+}
+
+void PackedSequence::reserve(size_t bases) {
+    size_t wordsNeeded = (bases + BASES_PER_WORD - 1) / BASES_PER_WORD;
+    words.reserve(wordsNeeded);
+    nBlocks.reserve((wordsNeeded + 63) / 64);
+}
+
+void PackedSequence::markNBlocks(size_t start, size_t len) {
+    if (len == 0) return;
+    size_t first = start >> 5;
+    size_t last = (start + len - 1) >> 5;
+    for (size_t w = first; w <= last; w++) {
+        nBlocks[w >> 6] |= 1ULL << (w & 63);
+    }
+}
+
+void PackedSequence::clearCodes(size_t start, size_t len) {
+    size_t end = start + len;
+    while (start < end) {
+        size_t w = start >> 5;
+        size_t first = start & 31;
+        size_t count = min<size_t>(BASES_PER_WORD - first, end - start);
+        uint64_t mask = count == BASES_PER_WORD ? ~0ULL : ((1ULL << (count * 2)) - 1) << (first * 2);
+        words[w] &= ~mask;
+        start += count;
+    }
+}
+
+bool PackedSequence::isNSlow(size_t pos) const {
+    auto it = upper_bound(nRuns.begin(), nRuns.end(), pos,
+        [](size_t p, const NRun& run) { return p < run.start; });
+    if (it == nRuns.begin()) return false;
+    --it;
+    return pos < it->start + it->length;
+}
+
+void PackedSequence::push_back(char base) {
+    switch (base) {
+    case 'A': case 'a': appendCode(0); break;
+    case 'C': case 'c': appendCode(1); break;
+    case 'G': case 'g': appendCode(2); break;
+    case 'T': case 't': appendCode(3); break;
+    default: appendN(1); break;
+    }
+}
+
+void PackedSequence::appendCode(uint8_t code) {
+    size_t wordIndex = length >> 5;
+    if (wordIndex == words.size()) {
+        words.push_back(0);
+        if ((wordIndex >> 6) == nBlocks.size()) nBlocks.push_back(0);
+    }
+    words[wordIndex] |= static_cast<uint64_t>(code & 3) << ((length & 31) * 2);
+    length++;
+}
+
+void PackedSequence::appendN(size_t count) {
+    if (count == 0) return;
+
+    size_t start = length;
+    length += count;
+    words.resize((length + BASES_PER_WORD - 1) / BASES_PER_WORD, 0);
+    nBlocks.resize((words.size() + 63) / 64, 0);
+
+    if (!nRuns.empty() && nRuns.back().start + nRuns.back().length == start) {
+        nRuns.back().length += count;
+    }
+    else {
+        nRuns.push_back({ start, count });
+    }
+    markNBlocks(start, count);
+}
+
+void PackedSequence::assign(size_t bases) {
+    clear();
+    length = bases;
+    words.assign((bases + BASES_PER_WORD - 1) / BASES_PER_WORD, 0);
+    nBlocks.assign((words.size() + 63) / 64, 0);
+}
+
+void PackedSequence::markN(size_t start, size_t count) {
+    if (count == 0) return;
+    if (!nRuns.empty() && nRuns.back().start + nRuns.back().length == start) {
+        nRuns.back().length += count;
+    }
+    else {
+        nRuns.push_back({ start, count });
+    }
+    markNBlocks(start, count);
+}
+
+void PackedSequence::append(const string& bases) {
+    for (char c : bases) push_back(c);
+}
+
+void PackedSequence::append(const PackedSequence& other) {
+    if (other.empty()) return;
+
+    size_t offset = length;
+    unsigned shift = static_cast<unsigned>((length & 31) * 2);
+
+    if (shift == 0) {
+        words.insert(words.end(), other.words.begin(), other.words.end());
+    }
+    else {
+        for (uint64_t w : other.words) {
+            words.back() |= w << shift;
+            words.push_back(w >> (64 - shift));
+        }
+    }
+
+    length += other.length;
+    words.resize((length + BASES_PER_WORD - 1) / BASES_PER_WORD);
+    nBlocks.resize((words.size() + 63) / 64, 0);
+
+    for (const NRun& run : other.nRuns) {
+        size_t start = run.start + offset;
+        if (!nRuns.empty() && nRuns.back().start + nRuns.back().length == start) {
+            nRuns.back().length += run.length;
+        }
+        else {
+            nRuns.push_back({ start, run.length });
+        }
+        markNBlocks(start, run.length);
+    }
+}
+
+uint64_t PackedSequence::wordAt(size_t pos) const {
+    size_t w = pos >> 5;
+    unsigned shift = static_cast<unsigned>((pos & 31) * 2);
+    uint64_t value = words[w] >> shift;
+    if (shift != 0 && w + 1 < words.size()) {
+        value |= words[w + 1] << (64 - shift);
+    }
+    return value;
+}
+
+size_t PackedSequence::countN() const {
+    size_t total = 0;
+    for (const NRun& run : nRuns) total += run.length;
+    return total;
+}
+
+bool PackedSequence::rangeHasN(size_t pos, size_t len) const {
+    if (len == 0 || nRuns.empty()) return false;
+    auto it = upper_bound(nRuns.begin(), nRuns.end(), pos,
+        [](size_t p, const NRun& run) { return p < run.start + run.length; });
+    return it != nRuns.end() && it->start < pos + len;
+}
+
+// Complement is XOR with 3 (A<->T, C<->G); each word is reversed 2 bits at a
+// time, then the word order is reversed and the padding shifted out.
+void PackedSequence::reverseComplement() {
+    if (length == 0) return;
+
+    for (uint64_t& w : words) {
+        uint64_t x = ~w;
+        x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+        x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+        x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+        w = (x >> 32) | (x << 32);
+    }
+    reverse(words.begin(), words.end());
+
+    unsigned pad = static_cast<unsigned>(words.size() * BASES_PER_WORD - length) * 2;
+    if (pad != 0) {
+        for (size_t w = 0; w + 1 < words.size(); w++) {
+            words[w] = (words[w] >> pad) | (words[w + 1] << (64 - pad));
+        }
+        words.back() >>= pad;
+    }
+
+    vector<NRun> mirrored;
+    mirrored.reserve(nRuns.size());
+    for (auto it = nRuns.rbegin(); it != nRuns.rend(); ++it) {
+        mirrored.push_back({ length - it->start - it->length, it->length });
+    }
+    nRuns.swap(mirrored);
+
+    fill(nBlocks.begin(), nBlocks.end(), 0);
+    for (const NRun& run : nRuns) {
+        clearCodes(run.start, run.length);
+        markNBlocks(run.start, run.length);
+    }
+}
+
+PackedSequence PackedSequence::slice(size_t pos, size_t len) const {
+    PackedSequence result;
+    if (pos >= length) return result;
+    len = min(len, length - pos);
+
+    size_t wordsNeeded = (len + BASES_PER_WORD - 1) / BASES_PER_WORD;
+    result.words.resize(wordsNeeded);
+    for (size_t w = 0; w < wordsNeeded; w++) {
+        result.words[w] = wordAt(pos + w * BASES_PER_WORD);
+    }
+    unsigned tail = static_cast<unsigned>(len & 31);
+    if (tail != 0) {
+        result.words.back() &= (1ULL << (tail * 2)) - 1;
+    }
+
+    result.length = len;
+    result.nBlocks.assign((wordsNeeded + 63) / 64, 0);
+
+    auto it = upper_bound(nRuns.begin(), nRuns.end(), pos,
+        [](size_t p, const NRun& run) { return p < run.start + run.length; });
+    for (; it != nRuns.end() && it->start < pos + len; ++it) {
+        size_t start = max(it->start, pos);
+        size_t end = min(it->start + it->length, pos + len);
+        result.nRuns.push_back({ start - pos, end - start });
+        result.markNBlocks(start - pos, end - start);
+    }
+    return result;
+}
+
+void PackedSequence::decode(size_t pos, size_t len, char* out) const {
+    static const char BASES[4] = { 'A', 'C', 'G', 'T' };
+
+    size_t i = 0;
+    while (i < len) {
+        uint64_t w = wordAt(pos + i);
+        size_t chunk = min<size_t>(BASES_PER_WORD, len - i);
+        for (size_t j = 0; j < chunk; j++) {
+            out[i + j] = BASES[w & 3];
+            w >>= 2;
+        }
+        i += chunk;
+    }
+
+    auto it = upper_bound(nRuns.begin(), nRuns.end(), pos,
+        [](size_t p, const NRun& run) { return p < run.start + run.length; });
+    for (; it != nRuns.end() && it->start < pos + len; ++it) {
+        size_t start = max(it->start, pos);
+        size_t end = min(it->start + it->length, pos + len);
+        memset(out + (start - pos), 'N', end - start);
+    }
+}
+
+string PackedSequence::toString() const {
+    return toString(0, length);
+}
+
+string PackedSequence::toString(size_t pos, size_t len) const {
+    if (pos >= length) return string();
+    len = min(len, length - pos);
+    string result(len, 'A');
+    decode(pos, len, &result[0]);
+    return result;
+}
+
+size_t PackedSequence::memoryUsage() const {
+    return words.capacity() * sizeof(uint64_t)
+        + nBlocks.capacity() * sizeof(uint64_t)
+        + nRuns.capacity() * sizeof(NRun);
+}
\ No newline at end of file
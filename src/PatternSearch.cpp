@@ -1,15 +1,29 @@
 #include "PatternSearch.h"
-#include <unordered_map>
+#include "PackedSequence.h"
+#include "SuffixArrayIndex.h"
+#include "FMIndex.h"
+#include "SimdSearch.h"
+#include "DNAUtils.h"
+#include "MatchSink.h"
+#include "DnaBoyerMoore.h"
+#include "RabinKarp.h"
+#include "SequenceLoader.h"
+#include "ParallelJobs.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <cmath>
+#include <cstddef>
 #include <chrono>
 
 using namespace std;
 
-static vector<int> buildLPS(const string& pat) {
-    vector<int> lps(pat.size(), 0);
-    int len = 0;
+static vector<size_t> buildLPS(const string& pat) {
+    vector<size_t> lps(pat.size(), 0);
+    size_t len = 0;
 
-    for (int i = 1; i < pat.size(); ) {
+    for (size_t i = 1; i < pat.size(); ) {
         if (pat[i] == pat[len]) {
             lps[i++] = ++len;
         }
@@ -21,19 +35,21 @@ static vector<int> buildLPS(const string& pat) {
     return lps;
 }
 
-vector<int> PatternSearch::kmp(const string& text, const string& pat) {
-    vector<int> result;
+// Each engine reports matches through emit(position), which returns false to
+// stop the scan; the engines themselves return false if they were stopped.
+template <typename Text, typename Emit>
+static bool kmpImpl(const Text& text, const string& pat, Emit&& emit) {
     if (pat.empty() || text.empty() || pat.size() > text.size())
-        return result;
+        return true;
 
     auto lps = buildLPS(pat);
-    int i = 0, j = 0;
+    size_t i = 0, j = 0;
 
     while (i < text.size()) {
         if (text[i] == pat[j]) {
             i++; j++;
             if (j == pat.size()) {
-                result.push_back(i - j);
+                if (!emit(i - j)) return false;
                 j = lps[j - 1];
             }
         }
@@ -42,101 +58,746 @@ vector<int> PatternSearch::kmp(const string& text, const string& pat) {
             else i++;
         }
     }
-    return result;
+    return true;
 }
 
-vector<int> PatternSearch::boyerMoore(const string& text, const string& pat) {
-    vector<int> result;
+template <typename Text, typename Emit>
+static bool boyerMooreImpl(const Text& text, const string& pat, Emit&& emit) {
     if (pat.empty() || text.empty() || pat.size() > text.size())
-        return result;
+        return true;
 
-    unordered_map<char, int> badChar;
-    int patLen = pat.size();
-    int textLen = text.size();
+    ptrdiff_t badChar[256];
+    fill(begin(badChar), end(badChar), -1);
+    size_t patLen = pat.size();
+    size_t textLen = text.size();
 
-    for (int i = 0; i < patLen; i++) {
-        badChar[pat[i]] = i;
+    for (size_t i = 0; i < patLen; i++) {
+        badChar[static_cast<unsigned char>(pat[i])] = static_cast<ptrdiff_t>(i);
     }
 
-    int shift = 0;
-    while (shift <= (textLen - patLen)) {
-        int j = patLen - 1;
+    size_t shift = 0;
+    while (shift <= textLen - patLen) {
+        ptrdiff_t j = static_cast<ptrdiff_t>(patLen) - 1;
 
         while (j >= 0 && pat[j] == text[shift + j]) {
             j--;
         }
 
         if (j < 0) {
-            result.push_back(shift);
-            shift += (shift + patLen < textLen) ? patLen - badChar[text[shift + patLen]] : 1;
+            if (!emit(shift)) return false;
+            shift += (shift + patLen < textLen)
+                ? static_cast<size_t>(static_cast<ptrdiff_t>(patLen) -
+                    badChar[static_cast<unsigned char>(text[shift + patLen])])
+                : 1;
         }
         else {
-            int badCharShift = j - badChar[text[shift + j]];
-            shift += max(1, badCharShift);
+            ptrdiff_t badCharShift = j - badChar[static_cast<unsigned char>(text[shift + j])];
+            shift += static_cast<size_t>(max<ptrdiff_t>(1, badCharShift));
         }
     }
-    return result;
+    return true;
 }
 
-vector<int> PatternSearch::naiveSearch(const string& text, const string& pat) {
-    vector<int> result;
+template <typename Text, typename Emit>
+static bool naiveSearchImpl(const Text& text, const string& pat, Emit&& emit) {
     if (pat.empty() || text.empty() || pat.size() > text.size())
-        return result;
+        return true;
 
-    for (int i = 0; i <= text.size() - pat.size(); i++) {
+    for (size_t i = 0; i <= text.size() - pat.size(); i++) {
         bool found = true;
-        for (int j = 0; j < pat.size(); j++) {
+        for (size_t j = 0; j < pat.size(); j++) {
             if (text[i + j] != pat[j]) {
                 found = false;
                 break;
             }
         }
-        if (found) result.push_back(i);
+        if (found && !emit(i)) return false;
     }
-    return result;
+    return true;
+}
+
+// IUPAC code -> set of bases as a 4-bit mask (A=1, C=2, G=4, T=8); 0 if invalid.
+static uint8_t iupacClass(char c) {
+    switch (toupper(static_cast<unsigned char>(c))) {
+    case 'A': return 1;
+    case 'C': return 2;
+    case 'G': return 4;
+    case 'T': case 'U': return 8;
+    case 'R': return 1 | 4;
+    case 'Y': return 2 | 8;
+    case 'S': return 2 | 4;
+    case 'W': return 1 | 8;
+    case 'K': return 4 | 8;
+    case 'M': return 1 | 2;
+    case 'B': return 2 | 4 | 8;
+    case 'D': return 1 | 4 | 8;
+    case 'H': return 1 | 2 | 8;
+    case 'V': return 1 | 2 | 4;
+    case 'N': return 15;
+    default: return 0;
+    }
+}
+
+template <typename Fn>
+static void forEachSymbol(const string& text, Fn&& fn) {
+    for (size_t i = 0; i < text.size(); i++) {
+        int symbol;
+        switch (text[i]) {
+        case 'A': symbol = 0; break;
+        case 'C': symbol = 1; break;
+        case 'G': symbol = 2; break;
+        case 'T': symbol = 3; break;
+        default: symbol = 4; break;
+        }
+        if (!fn(i, symbol)) return;
+    }
+}
+
+template <typename Fn>
+static void forEachSymbol(const PackedSequence& text, Fn&& fn) {
+    text.forEachSymbol(0, text.size(), fn);
+}
+
+// A stretch [begin, begin + length) of a packed sequence searched in place.
+// Engines treat it as a text of its own, so positions are relative to begin.
+struct PackedRange {
+    const PackedSequence& seq;
+    size_t begin;
+    size_t length;
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    char operator[](size_t pos) const { return seq[begin + pos]; }
+};
+
+template <typename Fn>
+static void forEachSymbol(const PackedRange& text, Fn&& fn) {
+    text.seq.forEachSymbol(text.begin, text.begin + text.length,
+        [&](size_t pos, int symbol) { return fn(pos - text.begin, symbol); });
 }
 
-vector<int> PatternSearch::rabinKarp(const string& text, const string& pat) {
-    vector<int> result;
+// Rolling fingerprint over symbol codes (A/C/G/T = 0-3, anything else 4)
+// modulo 2^61-1, so a window is compared base by base only when its
+// fingerprint equals the pattern's.
+template <typename Text, typename Emit>
+static bool rabinKarpImpl(const Text& text, const string& pat, Emit&& emit) {
     if (pat.empty() || text.empty() || pat.size() > text.size())
-        return result;
+        return true;
 
-    const int prime = 101;
-    const int base = 256;
-    int patLen = pat.size();
-    int textLen = text.size();
+    size_t m = pat.size();
+    uint64_t patHash = 0;
+    for (char c : pat) {
+        uint64_t code = c == 'A' ? 0 : c == 'C' ? 1 : c == 'G' ? 2 : c == 'T' ? 3 : 4;
+        patHash = RabinKarp::addMod(RabinKarp::mulMod(patHash, RabinKarp::BASE), code);
+    }
+    uint64_t outgoing[5];   // symbol * BASE^(m-1), removed as the symbol leaves the window
+    for (uint64_t c = 0; c < 5; c++) outgoing[c] = RabinKarp::mulMod(c, RabinKarp::power(m - 1));
 
-    int patHash = 0;
-    int textHash = 0;
-    int h = 1;
+    vector<uint8_t> window(m);
+    size_t slot = 0;
+    size_t seen = 0;
+    uint64_t hash = 0;
+    bool running = true;
+    forEachSymbol(text, [&](size_t pos, int symbol) -> bool {
+        if (seen >= m) hash = RabinKarp::subMod(hash, outgoing[window[slot]]);
+        hash = RabinKarp::addMod(RabinKarp::mulMod(hash, RabinKarp::BASE), static_cast<uint64_t>(symbol));
+        window[slot] = static_cast<uint8_t>(symbol);
+        if (++slot == m) slot = 0;
+        if (++seen < m || hash != patHash) return true;
 
-    for (int i = 0; i < patLen - 1; i++) {
-        h = (h * base) % prime;
+        size_t start = pos + 1 - m;
+        size_t j = 0;
+        while (j < m && text[start + j] == pat[j]) j++;
+        if (j == m) running = emit(start);
+        return running;
+    });
+    return running;
+}
+
+// Fills the Shift-And masks for symbols A, C, G, T and N (words per symbol);
+// false if the pattern contains a non-IUPAC character.
+static bool buildClassMasks(const string& pat, size_t words, vector<uint64_t>& masks) {
+    masks.assign(5 * words, 0);
+    for (size_t i = 0; i < pat.size(); i++) {
+        uint8_t cls = iupacClass(pat[i]);
+        if (cls == 0) return false;
+        for (int b = 0; b < 4; b++) {
+            if (cls & (1 << b)) masks[b * words + (i >> 6)] |= 1ULL << (i & 63);
+        }
+        if (cls == 15) masks[4 * words + (i >> 6)] |= 1ULL << (i & 63);
     }
+    return true;
+}
 
-    for (int i = 0; i < patLen; i++) {
-        patHash = (base * patHash + pat[i]) % prime;
-        textHash = (base * textHash + text[i]) % prime;
+// Advances a multi-word Shift-And state by one symbol; true if the last pattern bit is set.
+static inline bool shiftAndStep(uint64_t* state, const uint64_t* mask, size_t words,
+    size_t lastWord, uint64_t lastBit)
+{
+    uint64_t carry = 1;
+    for (size_t w = 0; w < words; w++) {
+        uint64_t next = ((state[w] << 1) | carry) & mask[w];
+        carry = state[w] >> 63;
+        state[w] = next;
     }
+    return (state[lastWord] & lastBit) != 0;
+}
+
+// Shift-And over per-symbol class masks. An N in the text is an unknown base:
+// it matches only an N in the pattern, never a specific or partial code.
+template <typename Text, typename Emit>
+static bool iupacImpl(const Text& text, const string& pat, Emit&& emit) {
+    if (pat.empty() || text.empty() || pat.size() > text.size())
+        return true;
+
+    size_t m = pat.size();
+    size_t words = (m + 63) / 64;
+    vector<uint64_t> masks;
+    if (!buildClassMasks(pat, words, masks)) return true;
+
+    vector<uint64_t> state(words, 0);
+    size_t lastWord = (m - 1) >> 6;
+    uint64_t lastBit = 1ULL << ((m - 1) & 63);
+    bool running = true;
+    forEachSymbol(text, [&](size_t pos, int symbol) -> bool {
+        if (shiftAndStep(state.data(), &masks[symbol * words], words, lastWord, lastBit)) {
+            running = emit(pos + 1 - m);
+        }
+        return running;
+    });
+    return running;
+}
+
+static auto collectInto(vector<size_t>& out) {
+    return [&out](size_t pos) {
+        out.push_back(pos);
+        return true;
+    };
+}
+
+static auto emitTo(MatchSink& sink) {
+    return [&sink](size_t pos) { return sink.onMatch(pos); };
+}
+
+// Decodes the packed text in cache-sized chunks overlapping by pat.size() - 1
+// so a byte-oriented kernel(text, length, pat, offset, sink) can run over it.
+template <typename Kernel>
+static bool decodedImpl(const PackedRange& text, const string& pat, MatchSink& sink, Kernel&& kernel) {
+    if (pat.empty() || pat.size() > text.size()) return true;
+
+    const size_t CHUNK = 1 << 16;
+    vector<char> buffer(CHUNK + pat.size() - 1);
+    for (size_t pos = 0; pos + pat.size() <= text.size(); pos += CHUNK) {
+        size_t len = min(buffer.size(), text.size() - pos);
+        text.seq.decode(text.begin + pos, len, buffer.data());
+        if (!kernel(buffer.data(), len, pat, pos, sink)) return false;
+    }
+    return true;
+}
+
+template <typename Kernel>
+static bool decodedImpl(const string& text, const string& pat, MatchSink& sink, Kernel&& kernel) {
+    return kernel(text.data(), text.size(), pat, 0, sink);
+}
+
+static bool simdKernel(const char* text, size_t length, const string& pat, size_t offset, MatchSink& sink) {
+    return SimdSearch::find(text, length, pat, offset, sink);
+}
+
+static bool qgramImpl(const string& text, const string& pat, MatchSink& sink) {
+    return DnaBoyerMoore::qgram(text.data(), text.size(), pat, 0, sink);
+}
 
-    for (int i = 0; i <= textLen - patLen; i++) {
-        if (patHash == textHash) {
-            bool match = true;
-            for (int j = 0; j < patLen; j++) {
-                if (text[i + j] != pat[j]) {
-                    match = false;
-                    break;
+static bool qgramImpl(const PackedRange& text, const string& pat, MatchSink& sink) {
+    return DnaBoyerMoore::qgram(text.seq, text.begin, text.begin + text.length, pat, sink);
+}
+
+static PackedRange wholeText(const PackedSequence& text) {
+    return { text, 0, text.size() };
+}
+
+static vector<RecordRange> wholeRange(const PackedSequence& text) {
+    return { { 0, 0, text.size() } };
+}
+
+template <typename Text>
+static bool runImpl(PatternSearch::Algorithm algorithm, const Text& text, const string& pat, MatchSink& sink) {
+    switch (algorithm) {
+    case PatternSearch::KMP: return kmpImpl(text, pat, emitTo(sink));
+    case PatternSearch::BOYER_MOORE: return boyerMooreImpl(text, pat, emitTo(sink));
+    case PatternSearch::HORSPOOL: return decodedImpl(text, pat, sink, DnaBoyerMoore::horspool);
+    case PatternSearch::BM_GOOD_SUFFIX: return decodedImpl(text, pat, sink, DnaBoyerMoore::goodSuffix);
+    case PatternSearch::QGRAM_BM: return qgramImpl(text, pat, sink);
+    case PatternSearch::RABIN_KARP: return rabinKarpImpl(text, pat, emitTo(sink));
+    case PatternSearch::NAIVE: return naiveSearchImpl(text, pat, emitTo(sink));
+    case PatternSearch::SIMD: return decodedImpl(text, pat, sink, simdKernel);
+    case PatternSearch::IUPAC: return iupacImpl(text, pat, emitTo(sink));
+    default: return true;
+    }
+}
+
+// Forwards to both strand sinks while either still wants matches; used when
+// a palindromic pattern is searched once for both strands.
+class BothStrandsSink : public MatchSink {
+private:
+    MatchSink& plus;
+    MatchSink& minus;
+    bool plusActive = true;
+    bool minusActive = true;
+
+public:
+    BothStrandsSink(MatchSink& plusSink, MatchSink& minusSink) : plus(plusSink), minus(minusSink) {}
+    bool onMatch(size_t pos) override {
+        if (plusActive) plusActive = plus.onMatch(pos);
+        if (minusActive) minusActive = minus.onMatch(pos);
+        return plusActive || minusActive;
+    }
+    size_t positionsWanted() const override {
+        return max(plusActive ? plus.positionsWanted() : 0, minusActive ? minus.positionsWanted() : 0);
+    }
+    bool countsRest() const override {
+        return (plusActive && plus.countsRest()) || (minusActive && minus.countsRest());
+    }
+    bool onCount(size_t n) override {
+        if (plusActive && plus.countsRest()) plusActive = plus.onCount(n);
+        if (minusActive && minus.countsRest()) minusActive = minus.onCount(n);
+        return plusActive || minusActive;
+    }
+};
+
+// Passes hits from one record at a time on to the caller's sink, shifted by
+// offset. It outlives the record so a sink that stopped is not called again.
+class ShiftSink : public MatchSink {
+public:
+    MatchSink* target;
+    size_t offset = 0;
+
+    explicit ShiftSink(MatchSink* sink) : target(sink) {}
+    bool onMatch(size_t pos) override {
+        if (target && !target->onMatch(offset + pos)) target = nullptr;
+        return target != nullptr;
+    }
+    MatchSink* active() { return target ? this : nullptr; }
+};
+
+// Searches every record part of [begin, end) on its own, reporting positions
+// relative to begin.
+static bool runPieces(PatternSearch::Algorithm algorithm, const PackedSequence& text,
+    const vector<RecordRange>& ranges, size_t begin, size_t end, const string& pat, MatchSink& sink)
+{
+    ShiftSink shifted(&sink);
+    SequenceLoader::forEachRangePart(ranges, begin, end, pat.size(), [&](size_t from, size_t to) {
+        shifted.offset = from - begin;
+        runImpl(algorithm, PackedRange{ text, from, to - from }, pat, shifted);
+        return shifted.target != nullptr;
+    });
+    return shifted.target != nullptr;
+}
+
+// One caller sink of a chunked search, shared by all chunks.
+struct ChunkTarget {
+    MatchSink* sink = nullptr;
+    size_t keep = 0;                    // positions a chunk buffers at most
+    bool countRest = false;             // count hits past keep instead of stopping
+    atomic<bool> stopped{ true };
+    atomic<size_t> bound{ SIZE_MAX };   // lowest chunk known to satisfy the sink
+};
+
+struct ChunkHits {
+    vector<size_t> positions;
+    size_t extra = 0;
+};
+
+// Buffers one chunk's hits for one target: at most keep positions, then only
+// a count if the target wants one. It stops the chunk once the target has
+// stopped or an earlier chunk already holds everything the target needs.
+class ChunkSink : public MatchSink {
+private:
+    ChunkTarget& target;
+    ChunkHits& hits;
+    size_t chunk;
+    size_t offset;
+
+public:
+    ChunkSink(ChunkTarget& chunkTarget, ChunkHits& chunkHits, size_t index, size_t chunkStart)
+        : target(chunkTarget), hits(chunkHits), chunk(index), offset(chunkStart) {}
+    bool onMatch(size_t pos) override {
+        if (target.stopped.load(memory_order_relaxed) || chunk > target.bound.load(memory_order_relaxed))
+            return false;
+        if (hits.positions.size() < target.keep) {
+            hits.positions.push_back(offset + pos);
+            if (hits.positions.size() < target.keep || target.countRest) return true;
+
+            size_t bound = target.bound.load();
+            while (chunk < bound && !target.bound.compare_exchange_weak(bound, chunk)) {}
+            return false;
+        }
+        hits.extra++;
+        return true;
+    }
+};
+
+// Scans [0, length) in chunks overlapping by overlap bases, so every match
+// starts in exactly one chunk. scan(begin, end, plus, minus) searches one
+// chunk in place for up to two targets, reporting positions relative to
+// begin; a null sink skips that target. A finished chunk is replayed into the
+// targets as soon as every earlier chunk is done, so they see positions in
+// text order while later chunks are still being scanned. Returns false if
+// every target stopped early.
+template <typename Scan>
+static bool runChunks(size_t length, size_t overlap, unsigned threadCount, MatchSink* plusSink,
+    MatchSink* minusSink, Scan&& scan)
+{
+    ChunkTarget targets[2];
+    MatchSink* sinks[2] = { plusSink, minusSink };
+    for (int t = 0; t < 2; t++) {
+        if (!sinks[t]) continue;
+        targets[t].sink = sinks[t];
+        targets[t].keep = sinks[t]->positionsWanted();
+        targets[t].countRest = sinks[t]->countsRest();
+        targets[t].stopped = targets[t].keep == 0 && !targets[t].countRest;
+    }
+
+    size_t chunkCount = static_cast<size_t>(threadCount) * 4;
+    size_t chunkLen = (length + chunkCount - 1) / chunkCount;
+    vector<ChunkHits> hits(chunkCount * 2);
+    vector<char> done(chunkCount, 0);
+    size_t delivered = 0;
+    mutex deliverLock;
+
+    auto deliver = [&](size_t c) {
+        lock_guard<mutex> guard(deliverLock);
+        done[c] = 1;
+        for (; delivered < chunkCount && done[delivered]; delivered++) {
+            for (int t = 0; t < 2; t++) {
+                ChunkTarget& target = targets[t];
+                ChunkHits& chunk = hits[delivered * 2 + t];
+                if (!target.stopped) {
+                    bool running = true;
+                    for (size_t i = 0; i < chunk.positions.size() && running; i++) {
+                        running = target.sink->onMatch(chunk.positions[i]);
+                    }
+                    if (running && chunk.extra != 0) running = target.sink->onCount(chunk.extra);
+                    if (!running || delivered >= target.bound) target.stopped = true;
                 }
+                vector<size_t>().swap(chunk.positions);
             }
-            if (match) result.push_back(i);
         }
+    };
 
-        if (i < textLen - patLen) {
-            textHash = (base * (textHash - text[i] * h) + text[i + patLen]) % prime;
-            if (textHash < 0) textHash += prime;
+    ParallelJobs::run(0, chunkCount, threadCount, [&](size_t c) {
+        size_t begin = c * chunkLen;
+        ChunkSink plus(targets[0], hits[c * 2], c, begin);
+        ChunkSink minus(targets[1], hits[c * 2 + 1], c, begin);
+        MatchSink* chunkSinks[2] = { &plus, &minus };
+        for (int t = 0; t < 2; t++) {
+            if (targets[t].stopped || c > targets[t].bound) chunkSinks[t] = nullptr;
+        }
+        if (begin < length && (chunkSinks[0] || chunkSinks[1])) {
+            scan(begin, min(length, begin + chunkLen + overlap), chunkSinks[0], chunkSinks[1]);
         }
+        deliver(c);
+    });
+    return !targets[0].stopped || !targets[1].stopped;
+}
+
+// Threads worth using for a chunked search; at most 1 means search serially.
+static unsigned chunkThreads(PatternSearch::Algorithm algorithm, size_t textLength, size_t patLength,
+    unsigned threadCount)
+{
+    if (PatternSearch::isIndexed(algorithm) || PatternSearch::isApproximate(algorithm) ||
+        patLength == 0 || patLength > textLength) return 1;
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+
+    const size_t minChunk = 1 << 16;
+    return static_cast<unsigned>(min<size_t>(threadCount, textLength / minChunk));
+}
+
+vector<size_t> PatternSearch::kmp(const string& text, const string& pat) {
+    vector<size_t> result;
+    kmpImpl(text, pat, collectInto(result));
+    return result;
+}
+
+vector<size_t> PatternSearch::kmp(const PackedSequence& text, const string& pat) {
+    vector<size_t> result;
+    kmpImpl(text, pat, collectInto(result));
+    return result;
+}
+
+vector<size_t> PatternSearch::boyerMoore(const string& text, const string& pat) {
+    vector<size_t> result;
+    boyerMooreImpl(text, pat, collectInto(result));
+    return result;
+}
+
+vector<size_t> PatternSearch::boyerMoore(const PackedSequence& text, const string& pat) {
+    vector<size_t> result;
+    boyerMooreImpl(text, pat, collectInto(result));
+    return result;
+}
+
+vector<size_t> PatternSearch::rabinKarp(const string& text, const string& pat) {
+    vector<size_t> result;
+    rabinKarpImpl(text, pat, collectInto(result));
+    return result;
+}
+
+vector<size_t> PatternSearch::rabinKarp(const PackedSequence& text, const string& pat) {
+    vector<size_t> result;
+    rabinKarpImpl(text, pat, collectInto(result));
+    return result;
+}
+
+vector<size_t> PatternSearch::naiveSearch(const string& text, const string& pat) {
+    vector<size_t> result;
+    naiveSearchImpl(text, pat, collectInto(result));
+    return result;
+}
+
+vector<size_t> PatternSearch::naiveSearch(const PackedSequence& text, const string& pat) {
+    vector<size_t> result;
+    naiveSearchImpl(text, pat, collectInto(result));
+    return result;
+}
+
+vector<size_t> PatternSearch::simdSearch(const string& text, const string& pat) {
+    vector<size_t> result;
+    SimdSearch::find(text.data(), text.size(), pat, 0, result);
+    return result;
+}
+
+vector<size_t> PatternSearch::simdSearch(const PackedSequence& text, const string& pat) {
+    vector<size_t> result;
+    VectorSink sink(result);
+    decodedImpl(wholeText(text), pat, sink, simdKernel);
+    return result;
+}
+
+vector<size_t> PatternSearch::iupacSearch(const string& text, const string& pat) {
+    vector<size_t> result;
+    iupacImpl(text, pat, collectInto(result));
+    return result;
+}
+
+vector<size_t> PatternSearch::iupacSearch(const PackedSequence& text, const string& pat) {
+    vector<size_t> result;
+    iupacImpl(text, pat, collectInto(result));
+    return result;
+}
+
+bool PatternSearch::isDegenerate(const string& pat) {
+    for (char c : pat) {
+        uint8_t cls = iupacClass(c);
+        if (cls != 0 && cls != 1 && cls != 2 && cls != 4 && cls != 8) return true;
+    }
+    return false;
+}
+
+// Runs the pattern and its reverse complement as two Shift-And automata over
+// the same symbol stream of [begin, end), so both strands cost a single pass.
+// Positions are relative to begin and a null sink skips its strand; the scan
+// ends once every requested strand's sink has stopped.
+static bool iupacStrandedImpl(const PackedSequence& text, size_t begin, size_t end, const string& pat,
+    const string& rc, MatchSink* plusSink, MatchSink* minusSink)
+{
+    size_t m = pat.size();
+    if (m == 0 || end < begin + m)
+        return true;
+
+    size_t words = (m + 63) / 64;
+    vector<uint64_t> plusMasks, minusMasks;
+    if (!buildClassMasks(pat, words, plusMasks)) return true;
+    bool palindrome = rc == pat;
+    if (!palindrome) buildClassMasks(rc, words, minusMasks);
+
+    bool wantPlus = plusSink != nullptr;
+    bool wantMinus = minusSink != nullptr;
+    vector<uint64_t> plusState(words, 0), minusState(words, 0);
+    size_t lastWord = (m - 1) >> 6;
+    uint64_t lastBit = 1ULL << ((m - 1) & 63);
+    text.forEachSymbol(begin, end, [&](size_t pos, int symbol) -> bool {
+        bool plusHit = (wantPlus || palindrome) &&
+            shiftAndStep(plusState.data(), &plusMasks[symbol * words], words, lastWord, lastBit);
+        bool minusHit = palindrome ? plusHit : wantMinus &&
+            shiftAndStep(minusState.data(), &minusMasks[symbol * words], words, lastWord, lastBit);
+
+        if (wantPlus && plusHit) wantPlus = plusSink->onMatch(pos + 1 - m - begin);
+        if (wantMinus && minusHit) wantMinus = minusSink->onMatch(pos + 1 - m - begin);
+        return wantPlus || wantMinus;
+    });
+    return wantPlus || wantMinus;
+}
+
+// Decodes [begin, end) once in cache-sized chunks and runs the SIMD kernel for
+// the pattern and its reverse complement over each chunk together. Positions
+// are relative to begin and a null sink skips its strand.
+static bool simdStrandedImpl(const PackedSequence& text, size_t begin, size_t end, const string& pat,
+    const string& rc, MatchSink* plusSink, MatchSink* minusSink)
+{
+    if (pat.empty() || end < begin + pat.size())
+        return true;
+
+    const size_t CHUNK = 1 << 16;
+    vector<char> buffer(CHUNK + pat.size() - 1);
+    for (size_t pos = begin; pos + pat.size() <= end; pos += CHUNK) {
+        size_t len = min(buffer.size(), end - pos);
+        text.decode(pos, len, buffer.data());
+        if (!SimdSearch::findStrands(buffer.data(), len, pat, rc, pos - begin, plusSink, minusSink)) return false;
+    }
+    return true;
+}
+
+void PatternSearch::iupacSearchStranded(const PackedSequence& text, const string& pat, Strand strand,
+    MatchSink& plusSink, MatchSink& minusSink)
+{
+    iupacStrandedImpl(text, 0, text.size(), pat, DNAUtils::reverseComplement(pat),
+        strand != MINUS_STRAND ? &plusSink : nullptr, strand != PLUS_STRAND ? &minusSink : nullptr);
+}
+
+void PatternSearch::simdSearchStranded(const PackedSequence& text, const string& pat, Strand strand,
+    MatchSink& plusSink, MatchSink& minusSink)
+{
+    string rc = DNAUtils::reverseComplement(pat);
+    MatchSink* plus = strand != MINUS_STRAND ? &plusSink : nullptr;
+    MatchSink* minus = strand != PLUS_STRAND ? &minusSink : nullptr;
+    BothStrandsSink both(plusSink, minusSink);
+    if (rc == pat && plus && minus) {
+        plus = &both;
+        minus = nullptr;
+    }
+    simdStrandedImpl(text, 0, text.size(), pat, rc, plus, minus);
+}
+
+vector<size_t> PatternSearch::suffixArray(const SuffixArrayIndex& index, const PackedSequence& text, const string& pat) {
+    return index.locate(text, pat);
+}
+
+vector<uint64_t> PatternSearch::fmIndex(const FMIndex& index, const string& pat) {
+    return index.locate(pat);
+}
+
+vector<size_t> PatternSearch::run(Algorithm algorithm, const PackedSequence& text, const string& pat) {
+    vector<size_t> result;
+    VectorSink sink(result);
+    run(algorithm, text, pat, sink);
+    return result;
+}
+
+bool PatternSearch::run(Algorithm algorithm, const PackedSequence& text, const string& pat, MatchSink& sink) {
+    return runImpl(algorithm, wholeText(text), pat, sink);
+}
+
+bool PatternSearch::run(Algorithm algorithm, const PackedSequence& text, const vector<RecordRange>& ranges,
+    const string& pat, MatchSink& sink)
+{
+    return runPieces(algorithm, text, ranges, 0, text.size(), pat, sink);
+}
+
+bool PatternSearch::run(Algorithm algorithm, const string& text, const string& pat, MatchSink& sink) {
+    return runImpl(algorithm, text, pat, sink);
+}
+
+vector<size_t> PatternSearch::runParallel(Algorithm algorithm, const PackedSequence& text, const string& pat,
+    unsigned threadCount)
+{
+    vector<size_t> result;
+    VectorSink sink(result);
+    runParallel(algorithm, text, pat, sink, threadCount);
+    return result;
+}
+
+// Workers search chunks of the packed text in place, each into its own sink,
+// and hits reach the caller's sink in text order (see runChunks). A sink that
+// needs only a few positions or a count keeps chunks from buffering the rest,
+// and once it is satisfied the chunks after it are abandoned.
+bool PatternSearch::runParallel(Algorithm algorithm, const PackedSequence& text, const string& pat,
+    MatchSink& sink, unsigned threadCount)
+{
+    return runParallel(algorithm, text, wholeRange(text), pat, sink, threadCount);
+}
+
+bool PatternSearch::runParallel(Algorithm algorithm, const PackedSequence& text, const vector<RecordRange>& ranges,
+    const string& pat, MatchSink& sink, unsigned threadCount)
+{
+    unsigned threads = chunkThreads(algorithm, text.size(), pat.size(), threadCount);
+    if (threads <= 1) {
+        return run(algorithm, text, ranges, pat, sink);
     }
+    return runChunks(text.size(), pat.size() - 1, threads, &sink, nullptr,
+        [&](size_t begin, size_t end, MatchSink* chunkSink, MatchSink*) {
+            runPieces(algorithm, text, ranges, begin, end, pat, *chunkSink);
+        });
+}
+
+// A palindromic pattern (its own reverse complement) is searched once and
+// reported on both strands. SIMD and IUPAC search both strands in one pass,
+// chunked across threads like runParallel; the other engines search the
+// reverse-complemented pattern separately.
+void PatternSearch::runStranded(Algorithm algorithm, const PackedSequence& text, const string& pat,
+    Strand strand, MatchSink& plusSink, MatchSink& minusSink, unsigned threadCount)
+{
+    runStranded(algorithm, text, wholeRange(text), pat, strand, plusSink, minusSink, threadCount);
+}
 
+void PatternSearch::runStranded(Algorithm algorithm, const PackedSequence& text, const vector<RecordRange>& ranges,
+    const string& pat, Strand strand, MatchSink& plusSink, MatchSink& minusSink, unsigned threadCount)
+{
+    auto search = [&](const string& p, MatchSink& sink) {
+        if (threadCount > 1) runParallel(algorithm, text, ranges, p, sink, threadCount);
+        else run(algorithm, text, ranges, p, sink);
+    };
+
+    string rc = DNAUtils::reverseComplement(pat);
+    if (strand == BOTH_STRANDS && rc == pat) {
+        BothStrandsSink both(plusSink, minusSink);
+        search(pat, both);
+        return;
+    }
+    if (strand == BOTH_STRANDS && (algorithm == SIMD || algorithm == IUPAC)) {
+        auto scan = [&](size_t begin, size_t end, MatchSink* plus, MatchSink* minus) {
+            ShiftSink plusShifted(plus), minusShifted(minus);
+            SequenceLoader::forEachRangePart(ranges, begin, end, pat.size(), [&](size_t from, size_t to) {
+                plusShifted.offset = minusShifted.offset = from - begin;
+                if (algorithm == SIMD) {
+                    simdStrandedImpl(text, from, to, pat, rc, plusShifted.active(), minusShifted.active());
+                }
+                else {
+                    iupacStrandedImpl(text, from, to, pat, rc, plusShifted.active(), minusShifted.active());
+                }
+                return plusShifted.target || minusShifted.target;
+            });
+        };
+        unsigned threads = threadCount > 1 ? chunkThreads(algorithm, text.size(), pat.size(), threadCount) : 1;
+        if (threads <= 1) scan(0, text.size(), &plusSink, &minusSink);
+        else runChunks(text.size(), pat.size() - 1, threads, &plusSink, &minusSink, scan);
+        return;
+    }
+    if (strand != MINUS_STRAND) search(pat, plusSink);
+    if (strand != PLUS_STRAND) search(rc, minusSink);
+}
+
+vector<StrandedMatch> PatternSearch::runStranded(Algorithm algorithm, const PackedSequence& text,
+    const string& pat, Strand strand, unsigned threadCount)
+{
+    vector<size_t> plus, minus;
+    VectorSink plusSink(plus), minusSink(minus);
+    runStranded(algorithm, text, pat, strand, plusSink, minusSink, threadCount);
+    return mergeStrands(plus, minus);
+}
+
+vector<StrandedMatch> PatternSearch::mergeStrands(const vector<size_t>& plus, const vector<size_t>& minus) {
+    vector<StrandedMatch> result;
+    result.reserve(plus.size() + minus.size());
+
+    size_t i = 0, j = 0;
+    while (i < plus.size() || j < minus.size()) {
+        if (j == minus.size() || (i < plus.size() && plus[i] <= minus[j])) {
+            result.push_back({ plus[i++], '+' });
+        }
+        else {
+            result.push_back({ minus[j++], '-' });
+        }
+    }
     return result;
 }
 
@@ -144,7 +805,16 @@ vector<string> PatternSearch::getAlgorithmNames() {
     return {
         "KMP (Knuth-Morris-Pratt)",
         "Boyer-Moore",
-        "Rabin-Karp",
-        "Naive Search"
+        "Horspool (DNA array shifts)",
+        "Boyer-Moore + Good Suffix",
+        "Q-gram Horspool (q=2-4, packed)",
+        "Rabin-Karp (61-bit fingerprint)",
+        "Naive Search",
+        string("SIMD First/Last Byte (") + SimdSearch::backendName(SimdSearch::active()) + ")",
+        "IUPAC Degenerate (Shift-And)",
+        "Approximate: Hamming (Shift-Or)",
+        "Approximate: Edit Distance (Myers)",
+        "Suffix Array (indexed)",
+        "FM-Index (compressed)"
     };
 }
\ No newline at end of file
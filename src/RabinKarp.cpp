@@ -0,0 +1,95 @@
+#include "RabinKarp.h"
+
+using namespace std;
+
+static int baseCode(char c) {
+    switch (c) {
+    case 'A': case 'a': return 0;
+    case 'C': case 'c': return 1;
+    case 'G': case 'g': return 2;
+    case 'T': case 't': return 3;
+    default: return -1;
+    }
+}
+
+uint64_t RabinKarp::power(size_t exponent) {
+    uint64_t result = 1;
+    uint64_t base = BASE;
+    while (exponent > 0) {
+        if (exponent & 1) result = mulMod(result, base);
+        base = mulMod(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+RabinKarp::RabinKarp() : filterMask(0), outgoing(), length(0) {}
+
+void RabinKarp::clear() {
+    names.clear();
+    sequences.clear();
+    codes.clear();
+    firstProbe.clear();
+    nextSame.clear();
+    filter.clear();
+    filterMask = 0;
+    length = 0;
+}
+
+bool RabinKarp::addProbe(const string& sequence, const string& name) {
+    if (sequence.empty()) return false;
+    if (length != 0 && sequence.size() != length) return false;
+
+    vector<uint8_t> probeCodes;
+    probeCodes.reserve(sequence.size());
+    uint64_t hash = 0;
+    for (char c : sequence) {
+        int code = baseCode(c);
+        if (code < 0) return false;
+        probeCodes.push_back(static_cast<uint8_t>(code));
+        hash = addMod(mulMod(hash, BASE), static_cast<uint64_t>(code));
+    }
+
+    if (length == 0) {
+        length = sequence.size();
+        uint64_t top = power(length - 1);
+        for (uint64_t c = 0; c < 4; c++) outgoing[c] = mulMod(c, top);
+    }
+
+    int32_t index = static_cast<int32_t>(sequences.size());
+    names.push_back(name.empty() ? sequence : name);
+    sequences.push_back(sequence);
+    codes.push_back(move(probeCodes));
+    nextSame.push_back(-1);
+
+    auto inserted = firstProbe.emplace(hash, index);
+    if (!inserted.second) {
+        int32_t p = inserted.first->second;
+        while (nextSame[p] >= 0) p = nextSame[p];
+        nextSame[p] = index;
+    }
+
+    if (static_cast<uint64_t>(sequences.size()) * 16 > filterMask + 1) rebuildFilter();
+    else filter[(hash & filterMask) >> 6] |= 1ULL << (hash & 63);
+    return true;
+}
+
+// Sized for about 16 bits per probe so most windows are rejected before the
+// hash lookup.
+void RabinKarp::rebuildFilter() {
+    uint64_t bits = 1 << 12;
+    while (bits < static_cast<uint64_t>(sequences.size()) * 16) bits <<= 1;
+    filterMask = bits - 1;
+    filter.assign(bits / 64, 0);
+    for (const auto& entry : firstProbe) {
+        filter[(entry.first & filterMask) >> 6] |= 1ULL << (entry.first & 63);
+    }
+}
+
+vector<size_t> RabinKarp::countMatches(const PackedSequence& text, const vector<RecordRange>& ranges,
+    ScreenStats& stats) const
+{
+    vector<size_t> counts(sequences.size(), 0);
+    stats = scan(text, ranges, [&](size_t, size_t probe) { counts[probe]++; });
+    return counts;
+}
\ No newline at end of file
@@ -1,102 +1,571 @@
 #include "SequenceLoader.h"
+#include "PackedSequence.h"
+#include "MappedFile.h"
+#include "ParallelJobs.h"
 #include <fstream>
 #include <iostream>
 #include <cctype>
+#include <cstring>
+#include <cstdint>
 #include <filesystem>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <utility>
 
 using namespace std;
 
-bool SequenceLoader::loadFASTA(const string& filename, string& outSeq, string& outHeader) {
-    try {
-        filesystem::path p(filename);
+namespace {
+    enum : uint8_t { BASE_N = 4, SKIP = 5, INVALID = 6 };
 
-        if (!filesystem::exists(p)) {
-            cerr << "Error: File does not exist: " << p << '\n';
-            return false;
+    struct BaseTable {
+        uint8_t codes[256];
+
+        BaseTable() {
+            memset(codes, INVALID, sizeof(codes));
+            const char* bases = "ACGT";
+            for (uint8_t i = 0; i < 4; i++) {
+                codes[static_cast<unsigned char>(bases[i])] = i;
+                codes[static_cast<unsigned char>(tolower(bases[i]))] = i;
+            }
+            codes['N'] = codes['n'] = BASE_N;
+            codes[' '] = codes['\t'] = codes['\r'] = codes['\n'] = SKIP;
+            codes['\v'] = codes['\f'] = SKIP;
         }
+    };
+
+    const BaseTable BASE_TABLE;
 
-        uintmax_t filesize = 0;
-        try {
-            filesize = filesystem::file_size(p);
+    size_t packChunk(const char* begin, const char* end, PackedSequence& out) {
+        size_t invalidChars = 0;
+        size_t pendingN = 0;
+
+        for (const char* p = begin; p < end; p++) {
+            uint8_t code = BASE_TABLE.codes[static_cast<unsigned char>(*p)];
+            if (code < BASE_N) {
+                if (pendingN > 0) {
+                    out.appendN(pendingN);
+                    pendingN = 0;
+                }
+                out.appendCode(code);
+            }
+            else if (code != SKIP) {
+                if (code == INVALID) invalidChars++;
+                pendingN++;
+            }
         }
-        catch (...) {}
 
-        ifstream file(p, ios::binary);
-        if (!file.is_open()) {
-            cerr << "Error: Could not open file: " << p << '\n';
-            return false;
+        out.appendN(pendingN);
+        return invalidChars;
+    }
+
+    size_t countBases(const char* begin, const char* end) {
+        size_t bases = 0;
+        for (const char* p = begin; p < end; p++) {
+            bases += BASE_TABLE.codes[static_cast<unsigned char>(*p)] != SKIP;
         }
+        return bases;
+    }
+
+    // What a chunk packed in place leaves for the serial merge: the words it
+    // only partly covers, which it shares with its neighbours, and its N runs.
+    struct PackedChunk {
+        vector<pair<size_t, uint64_t>> edgeWords;
+        vector<NRun> nRuns;
+        size_t invalidChars = 0;
+    };
 
-        outSeq.clear();
-        outHeader.clear();
+    // Packs the bases of [begin, end) into words as positions first..last-1.
+    // Words the chunk covers completely are written directly, so chunks with
+    // disjoint positions can be packed concurrently into the same words.
+    void packChunkAt(const char* begin, const char* end, size_t first, size_t last, uint64_t* words,
+        PackedChunk& out)
+    {
+        const size_t B = PackedSequence::BASES_PER_WORD;
+        size_t pos = first;
+        uint64_t word = 0;
+        auto store = [&]() {
+            size_t w = (pos - 1) / B;
+            if (w * B >= first && (w + 1) * B <= last) words[w] = word;
+            else out.edgeWords.push_back({ w, word });
+            word = 0;
+        };
 
-        if (filesize > 0 && filesize < (uintmax_t)(4ULL * 1024 * 1024 * 1024)) {
-            outSeq.reserve(static_cast<size_t>(min<uintmax_t>(filesize, (uintmax_t)(size_t(-1)))));
+        for (const char* p = begin; p < end; p++) {
+            uint8_t code = BASE_TABLE.codes[static_cast<unsigned char>(*p)];
+            if (code == SKIP) continue;
+            if (code >= BASE_N) {
+                if (code == INVALID) out.invalidChars++;
+                if (!out.nRuns.empty() && out.nRuns.back().start + out.nRuns.back().length == pos) {
+                    out.nRuns.back().length++;
+                }
+                else {
+                    out.nRuns.push_back({ pos, 1 });
+                }
+                code = 0;
+            }
+            word |= static_cast<uint64_t>(code) << ((pos % B) * 2);
+            if (++pos % B == 0) store();
         }
+        if (pos % B != 0 && pos > first) store();
+    }
 
-        cout << "Loading FASTA file: " << p << " ...\n";
+    struct RecordSpan {
+        string name;
+        string header;
+        const char* begin;
+        const char* end;
+    };
 
-        string line;
-        bool headerRead = false;
-        size_t invalidChars = 0;
-        size_t lineNum = 0;
+    struct Chunk {
+        size_t record;
+        const char* begin;
+        const char* end;
+    };
 
-        while (getline(file, line)) {
-            lineNum++;
+    string recordName(const string& header) {
+        size_t cut = header.find_first_of(" \t");
+        return header.substr(0, cut);
+    }
 
-            if (!line.empty() && line.back() == '\r') line.pop_back();
+    string faiPathFor(const string& filename) {
+        return filename + ".fai";
+    }
 
-            if (line.empty()) continue;
+    uint64_t byteOffset(const FaiEntry& entry, size_t pos) {
+        return entry.offset + (pos / entry.lineBases) * entry.lineWidth + pos % entry.lineBases;
+    }
 
-            if (line[0] == '>') {
-                if (headerRead) {
-                    cerr << "Warning: Multiple sequences in file. Loading only first sequence.\n";
-                    break;
-                }
-                outHeader = line.substr(1);
-                headerRead = true;
+    // Single pass over line starts: finds record boundaries and the .fai geometry.
+    bool scanRecords(const char* data, size_t size, vector<RecordSpan>& spans,
+        vector<FaiEntry>& entries, bool& indexable)
+    {
+        spans.clear();
+        entries.clear();
+        indexable = true;
+
+        const char* end = data + size;
+        const char* p = data;
+        while (p < end && isspace(static_cast<unsigned char>(*p))) p++;
+        if (p == end || *p != '>') return false;
+
+        bool sawShortLine = false;
+        while (p < end) {
+            const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+            const char* lineEnd = nl ? nl : end;
+            const char* next = nl ? nl + 1 : end;
+
+            if (*p == '>') {
+                string header(p + 1, lineEnd);
+                if (!header.empty() && header.back() == '\r') header.pop_back();
+                spans.push_back({ recordName(header), header, next, next });
+                entries.push_back({ spans.back().name, 0, static_cast<uint64_t>(next - data), 0, 0 });
+                sawShortLine = false;
             }
             else {
-                for (unsigned char uc : line) {
-                    if (isspace(uc)) continue;
-                    char base = static_cast<char>(toupper(uc));
-                    if (base == 'A' || base == 'C' || base == 'G' || base == 'T' || base == 'N') {
-                        outSeq.push_back(base);
+                FaiEntry& entry = entries.back();
+                size_t width = next - p;
+                size_t bases = lineEnd - p;
+                if (bases > 0 && lineEnd[-1] == '\r') bases--;
+
+                if (bases == 0) {
+                    sawShortLine = true;
+                }
+                else {
+                    if (entry.lineBases == 0) {
+                        entry.lineBases = bases;
+                        entry.lineWidth = width;
+                    }
+                    else if (sawShortLine || bases > entry.lineBases) {
+                        indexable = false;
                     }
-                    else {
-                        invalidChars++;
-                        outSeq.push_back('N');
+                    else if (bases < entry.lineBases || width != entry.lineWidth) {
+                        sawShortLine = true;
                     }
+                    entry.length += bases;
+                    spans.back().end = next;
                 }
             }
+            p = next;
+        }
+        return true;
+    }
+
+    bool spansFromIndex(const char* data, size_t size, const vector<FaiEntry>& index,
+        vector<RecordSpan>& spans)
+    {
+        spans.clear();
+        for (const FaiEntry& entry : index) {
+            if (entry.offset > size || (entry.length > 0 && entry.lineBases == 0)) return false;
+
+            uint64_t bytes = entry.length == 0 ? 0 : byteOffset(entry, entry.length - 1) + 1 - entry.offset;
+            if (entry.offset + bytes > size) return false;
+
+            const char* begin = data + entry.offset;
+            const char* headerStart = begin;
+            if (headerStart > data) headerStart--;
+            while (headerStart > data && headerStart[-1] != '\n') headerStart--;
+            if (*headerStart != '>') return false;
+
+            string header(headerStart + 1, begin);
+            while (!header.empty() && (header.back() == '\n' || header.back() == '\r')) header.pop_back();
+            spans.push_back({ entry.name, header, begin, begin + bytes });
+        }
+        return !spans.empty();
+    }
+
+    bool indexIsFresh(const string& filename) {
+        error_code ec;
+        string fai = faiPathFor(filename);
+        if (!filesystem::exists(fai, ec)) return false;
+        auto faiTime = filesystem::last_write_time(fai, ec);
+        if (ec) return false;
+        auto fastaTime = filesystem::last_write_time(filename, ec);
+        return !ec && faiTime >= fastaTime;
+    }
 
-            if (lineNum % 1000000 == 0) {
-                cout << "  Processed " << lineNum << " lines, "
-                    << (outSeq.size() / 1000000) << " Mbp\n";
+    // Packs the spans in parallel chunks of about a megabyte split at line ends.
+    // A first pass counts the bases of each chunk, so the second can pack every
+    // chunk straight into its place in outSeq. Returns the number of threads used.
+    unsigned packSpans(const vector<RecordSpan>& spans, unsigned threadCount, PackedSequence& outSeq,
+        vector<FastaRecord>& outRecords, size_t& invalidChars)
+    {
+        const size_t minChunk = 1 << 20;
+        vector<Chunk> chunks;
+        for (size_t r = 0; r < spans.size(); r++) {
+            const char* begin = spans[r].begin;
+            const char* end = spans[r].end;
+            while (end - begin > static_cast<ptrdiff_t>(2 * minChunk)) {
+                const char* nl = static_cast<const char*>(memchr(begin + minChunk, '\n', end - begin - minChunk));
+                if (!nl) break;
+                chunks.push_back({ r, begin, nl + 1 });
+                begin = nl + 1;
             }
+            chunks.push_back({ r, begin, end });
         }
 
-        file.close();
+        if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+        threadCount = static_cast<unsigned>(min<size_t>(threadCount, chunks.size()));
 
-        if (!headerRead) {
-            cerr << "Error: No header line found\n";
+        vector<size_t> offsets(chunks.size() + 1, 0);
+        ParallelJobs::run(0, chunks.size(), threadCount, [&](size_t c) {
+            offsets[c + 1] = countBases(chunks[c].begin, chunks[c].end);
+        });
+        for (size_t c = 0; c < chunks.size(); c++) offsets[c + 1] += offsets[c];
+
+        outSeq.assign(offsets.back());
+        uint64_t* words = outSeq.wordData();
+        vector<PackedChunk> packed(chunks.size());
+        ParallelJobs::run(0, chunks.size(), threadCount, [&](size_t c) {
+            packChunkAt(chunks[c].begin, chunks[c].end, offsets[c], offsets[c + 1], words, packed[c]);
+        });
+
+        invalidChars = 0;
+        outRecords.clear();
+        for (const RecordSpan& span : spans) {
+            outRecords.push_back({ span.name, span.header, 0, 0, 0 });
+        }
+        for (size_t c = 0; c < chunks.size(); c++) {
+            for (const auto& edge : packed[c].edgeWords) words[edge.first] |= edge.second;
+            for (const NRun& run : packed[c].nRuns) outSeq.markN(run.start, run.length);
+            invalidChars += packed[c].invalidChars;
+
+            FastaRecord& record = outRecords[chunks[c].record];
+            record.invalidChars += packed[c].invalidChars;
+            if (record.length == 0) record.offset = offsets[c];
+            record.length += offsets[c + 1] - offsets[c];
+        }
+        return threadCount;
+    }
+
+    bool lengthsMatch(const vector<FastaRecord>& records, const vector<FaiEntry>& index) {
+        if (records.size() != index.size()) return false;
+        for (size_t r = 0; r < records.size(); r++) {
+            if (records[r].length != index[r].length) return false;
+        }
+        return true;
+    }
+}
+
+bool SequenceLoader::readIndex(const string& faiPath, vector<FaiEntry>& outIndex) {
+    ifstream in(faiPath);
+    if (!in.is_open()) return false;
+
+    outIndex.clear();
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        istringstream fields(line);
+        FaiEntry entry;
+        if (!getline(fields, entry.name, '\t') ||
+            !(fields >> entry.length >> entry.offset >> entry.lineBases >> entry.lineWidth)) {
+            outIndex.clear();
             return false;
         }
+        outIndex.push_back(entry);
+    }
+    return !outIndex.empty();
+}
+
+bool SequenceLoader::writeIndex(const string& faiPath, const vector<FaiEntry>& index) {
+    ofstream out(faiPath, ios::binary);
+    if (!out.is_open()) return false;
+
+    for (const FaiEntry& entry : index) {
+        out << entry.name << '\t' << entry.length << '\t' << entry.offset << '\t'
+            << entry.lineBases << '\t' << entry.lineWidth << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool SequenceLoader::buildIndex(const string& filename, vector<FaiEntry>& outIndex) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        cerr << "Error: Could not map file: " << filename << '\n';
+        return false;
+    }
+
+    vector<RecordSpan> spans;
+    bool indexable = false;
+    if (!scanRecords(file.getData(), file.size(), spans, outIndex, indexable)) {
+        cerr << "Error: No header line found\n";
+        return false;
+    }
+    if (!indexable) {
+        cerr << "Error: Cannot index " << filename << ": inconsistent line lengths\n";
+        outIndex.clear();
+        return false;
+    }
+    return true;
+}
+
+bool SequenceLoader::loadIndex(const string& filename, vector<FaiEntry>& outIndex) {
+    if (indexIsFresh(filename) && readIndex(faiPathFor(filename), outIndex)) {
+        return true;
+    }
 
-        if (outSeq.empty()) {
-            cerr << "Error: No sequence data found\n";
+    if (!buildIndex(filename, outIndex)) return false;
+
+    if (!writeIndex(faiPathFor(filename), outIndex)) {
+        cerr << "Warning: Could not write index " << faiPathFor(filename) << '\n';
+    }
+    return true;
+}
+
+bool SequenceLoader::loadFASTAMapped(const string& filename, PackedSequence& outSeq,
+    vector<FastaRecord>& outRecords, unsigned threadCount)
+{
+    if (!filesystem::exists(filesystem::path(filename))) {
+        cerr << "Error: File does not exist: " << filename << '\n';
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(filename)) {
+        cerr << "Error: Could not map file: " << filename << '\n';
+        return false;
+    }
+
+    cout << "Loading FASTA file (memory-mapped): " << filename << " ...\n";
+
+    const char* data = file.getData();
+    vector<RecordSpan> spans;
+    vector<FaiEntry> index;
+    bool fromIndex = false;
+    bool indexable = false;
+
+    if (indexIsFresh(filename) && readIndex(faiPathFor(filename), index) &&
+        spansFromIndex(data, file.size(), index, spans)) {
+        fromIndex = true;
+    }
+    else if (!scanRecords(data, file.size(), spans, index, indexable)) {
+        cerr << "Error: No header line found\n";
+        return false;
+    }
+
+    // Packed into temporaries so a failed load leaves the caller's sequence as it was.
+    PackedSequence seq;
+    vector<FastaRecord> records;
+    size_t invalidChars = 0;
+    unsigned threadsUsed = packSpans(spans, threadCount, seq, records, invalidChars);
+    bool matches = lengthsMatch(records, index);
+
+    // A stale index is dropped; if it cannot be removed it is simply ignored
+    // and overwritten below when the rescanned file is indexable.
+    if (fromIndex && !matches) {
+        cerr << "Warning: Index " << faiPathFor(filename) << " is out of date, rescanning\n";
+        error_code ec;
+        filesystem::remove(faiPathFor(filename), ec);
+        fromIndex = false;
+        if (!scanRecords(data, file.size(), spans, index, indexable)) {
+            cerr << "Error: No header line found\n";
             return false;
         }
+        threadsUsed = packSpans(spans, threadCount, seq, records, invalidChars);
+        matches = lengthsMatch(records, index);
+    }
+    if (!fromIndex && indexable && matches) {
+        if (!writeIndex(faiPathFor(filename), index)) {
+            cerr << "Warning: Could not write index " << faiPathFor(filename) << '\n';
+        }
+    }
+
+    if (seq.empty()) {
+        cerr << "Error: No sequence data found\n";
+        return false;
+    }
+
+    if (invalidChars > 0) {
+        cerr << "Warning: Replaced " << invalidChars << " invalid characters with 'N'\n";
+    }
+
+    outSeq = move(seq);
+    outRecords = move(records);
+    cout << "Successfully loaded " << outSeq.size() << " base pairs in "
+        << outRecords.size() << " record(s) using " << threadsUsed << " thread(s)\n";
+    return true;
+}
+
+bool SequenceLoader::parseRegion(const string& region, const vector<string>& names, string& name,
+    size_t& start, size_t& end)
+{
+    name = region;
+    start = 0;
+    end = SIZE_MAX;
+
+    // As in samtools, a full match wins, so names that contain ':' (HLA alleles,
+    // for instance) still select the whole record.
+    if (region.empty() || find(names.begin(), names.end(), region) != names.end()) return !region.empty();
 
-        if (invalidChars > 0) {
-            cerr << "Warning: Replaced " << invalidChars << " invalid characters with 'N'\n";
+    size_t colon = region.rfind(':');
+    if (colon == string::npos || colon == 0 || colon + 1 == region.size()) return true;
+
+    string range;
+    for (char c : region.substr(colon + 1)) {
+        if (c != ',') range += c;
+    }
+    if (range.find_first_not_of("0123456789-") != string::npos) return true;
+
+    size_t dash = range.find('-');
+    try {
+        size_t first = stoull(range.substr(0, dash));
+        if (first == 0) return false;
+        start = first - 1;
+        if (dash != string::npos && dash + 1 < range.size()) {
+            end = stoull(range.substr(dash + 1));
+            if (end <= start) return false;
         }
+    }
+    catch (const exception&) {
+        return false;
+    }
+
+    name = region.substr(0, colon);
+    return true;
+}
+
+bool SequenceLoader::resolveRegion(const vector<FastaRecord>& records, const string& region,
+    size_t& storeStart, size_t& length)
+{
+    vector<string> names;
+    for (const FastaRecord& record : records) names.push_back(record.name);
 
-        cout << "Successfully loaded " << outSeq.size() << " base pairs\n";
+    string name;
+    size_t start = 0, end = 0;
+    if (!parseRegion(region, names, name, start, end)) return false;
+
+    for (const FastaRecord& record : records) {
+        if (record.name != name) continue;
+        size_t recordEnd = record.start + record.length;
+        if (start < record.start || start >= recordEnd) return false;
+        end = min(end, recordEnd);
+        storeStart = record.offset + (start - record.start);
+        length = end - start;
         return true;
     }
-    catch (const exception& e) {
-        cerr << "Exception while loading file: " << e.what() << '\n';
+    return false;
+}
+
+size_t SequenceLoader::findRecord(const vector<FastaRecord>& records, size_t storePos) {
+    auto it = upper_bound(records.begin(), records.end(), storePos,
+        [](size_t pos, const FastaRecord& record) { return pos < record.offset; });
+    return it == records.begin() ? 0 : static_cast<size_t>(it - records.begin() - 1);
+}
+
+vector<RecordRange> SequenceLoader::recordRanges(const vector<FastaRecord>& records, size_t storeStart,
+    size_t length)
+{
+    vector<RecordRange> spans;
+    size_t storeEnd = storeStart + length;
+    for (size_t r = records.empty() ? 0 : findRecord(records, storeStart); r < records.size(); r++) {
+        size_t begin = max(records[r].offset, storeStart);
+        size_t end = min(records[r].offset + records[r].length, storeEnd);
+        if (records[r].offset >= storeEnd) break;
+        if (begin < end) spans.push_back({ r, begin - storeStart, end - storeStart });
+    }
+    return spans;
+}
+
+bool SequenceLoader::fetchRegion(const string& filename, const string& region,
+    PackedSequence& outSeq, vector<FastaRecord>& outRecords)
+{
+    vector<FaiEntry> index;
+    if (!loadIndex(filename, index)) return false;
+
+    vector<string> names;
+    for (const FaiEntry& entry : index) names.push_back(entry.name);
+
+    string name;
+    size_t start = 0, end = 0;
+    if (!parseRegion(region, names, name, start, end)) {
+        cerr << "Error: Invalid region: " << region << '\n';
         return false;
     }
+
+    auto entry = find_if(index.begin(), index.end(),
+        [&](const FaiEntry& e) { return e.name == name; });
+    if (entry == index.end()) {
+        cerr << "Error: Record not found in index: " << name << '\n';
+        return false;
+    }
+
+    end = min(end, entry->length);
+    if (start >= end) {
+        cerr << "Error: Region is outside of record " << name << '\n';
+        return false;
+    }
+
+    uint64_t first = byteOffset(*entry, start);
+    uint64_t last = byteOffset(*entry, end - 1) + 1;
+
+    ifstream file(filename, ios::binary);
+    if (!file.is_open()) {
+        cerr << "Error: Could not open file: " << filename << '\n';
+        return false;
+    }
+
+    string buffer(static_cast<size_t>(last - first), '\0');
+    file.seekg(static_cast<streamoff>(first));
+    if (!file.read(&buffer[0], static_cast<streamsize>(buffer.size()))) {
+        cerr << "Error: Could not read region from " << filename << '\n';
+        return false;
+    }
+
+    outSeq = PackedSequence();
+    outSeq.reserve(end - start);
+    size_t invalidChars = packChunk(buffer.data(), buffer.data() + buffer.size(), outSeq);
+    if (invalidChars > 0) {
+        cerr << "Warning: Replaced " << invalidChars << " invalid characters with 'N'\n";
+    }
+
+    outRecords.clear();
+    string label = name + ":" + to_string(start + 1) + "-" + to_string(end);
+    outRecords.push_back({ name, label, 0, start, outSeq.size(), invalidChars });
+
+    cout << "Fetched " << outSeq.size() << " base pairs from " << name << ':'
+        << (start + 1) << '-' << end << " (" << buffer.size() << " bytes read)\n";
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "SequenceStats.h"
+#include "PackedSequence.h"
+#include "ParallelJobs.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <thread>
+
+using namespace std;
+
+static size_t power31(size_t exponent) {
+    size_t result = 1;
+    size_t base = 31;
+    while (exponent > 0) {
+        if (exponent & 1) result *= base;
+        base *= base;
+        exponent >>= 1;
+    }
+    return result;
+}
+
+struct ChunkStats {
+    size_t acgt[4] = {};    // A includes the A-coded slots under N runs
+    size_t hash = 0;
+    size_t length = 0;
+};
+
+static void scanWords(const PackedSequence& seq, size_t firstWord, size_t lastWord, ChunkStats& out) {
+    static const array<size_t, 33> POW = []() {
+        array<size_t, 33> table;
+        table[0] = 1;
+        for (size_t k = 1; k < table.size(); k++) table[k] = table[k - 1] * 31;
+        return table;
+        }();
+    const uint64_t lowBits = 0x5555555555555555ULL;
+
+    size_t c = 0, g = 0, t = 0;
+    size_t hash = 0;
+    size_t bases = 0;
+    for (size_t w = firstWord; w < lastWord; w++) {
+        size_t begin = w * PackedSequence::BASES_PER_WORD;
+        size_t count = min(PackedSequence::BASES_PER_WORD, seq.size() - begin);
+        uint64_t word = seq.word(w);
+        uint64_t mask = count == PackedSequence::BASES_PER_WORD ? ~0ULL : (1ULL << (count * 2)) - 1;
+
+        uint64_t lo = word & lowBits & mask;
+        uint64_t hi = (word >> 1) & lowBits & mask;
+        c += popcount(lo & ~hi);
+        g += popcount(hi & ~lo);
+        t += popcount(lo & hi);
+
+        // Values are 1-4 for A/C/G/T and 5 for N, as in DNAUtils::sequenceHash.
+        if (!seq.wordHasN(w)) {
+            size_t part = 0;
+            for (size_t i = 0; i < count; i++) {
+                part += (((word >> (i * 2)) & 3) + 1) * POW[count - 1 - i];
+            }
+            hash = hash * POW[count] + part;
+        }
+        else {
+            for (size_t i = 0; i < count; i++) {
+                hash = hash * 31 + (seq.isN(begin + i) ? 5 : ((word >> (i * 2)) & 3) + 1);
+            }
+        }
+        bases += count;
+    }
+
+    out.acgt[0] = bases - c - g - t;
+    out.acgt[1] = c;
+    out.acgt[2] = g;
+    out.acgt[3] = t;
+    out.hash = hash;
+    out.length = bases;
+}
+
+SequenceStats SequenceStats::compute(const PackedSequence& seq, unsigned threadCount) {
+    SequenceStats stats;
+    stats.length = seq.size();
+    if (seq.empty()) return stats;
+
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+    const size_t minChunkWords = 1 << 14;
+    size_t wordCount = seq.wordCount();
+    threadCount = static_cast<unsigned>(max<size_t>(1, min<size_t>(threadCount, wordCount / minChunkWords)));
+
+    vector<ChunkStats> chunks(threadCount);
+    size_t chunkWords = (wordCount + threadCount - 1) / threadCount;
+    ParallelJobs::run(0, threadCount, threadCount, [&](size_t t) {
+        size_t first = min(wordCount, t * chunkWords);
+        scanWords(seq, first, min(wordCount, first + chunkWords), chunks[t]);
+    });
+
+    for (const ChunkStats& chunk : chunks) {
+        for (int b = 0; b < 4; b++) stats.counts[b] += chunk.acgt[b];
+        stats.hash = stats.hash * power31(chunk.length) + chunk.hash;
+    }
+
+    for (const NRun& run : seq.getNRuns()) {
+        stats.counts[4] += run.length;
+        stats.longestNRun = max(stats.longestNRun, run.length);
+    }
+    stats.nRunCount = seq.getNRuns().size();
+    stats.counts[0] -= stats.counts[4];
+    return stats;
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "SimdSearch.h"
+#include "MatchSink.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#endif
+
+#ifdef SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#define TARGET_AVX2
+#define TARGET_SSE2
+#else
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#endif
+
+using namespace std;
+
+static unsigned lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+static bool scalarFind(const char* text, size_t length, const string& pat, size_t start,
+    size_t offset, MatchSink& sink)
+{
+    size_t m = pat.size();
+    if (length < m) return true;
+
+    const char first = pat[0];
+    const char last = pat[m - 1];
+    const char* end = text + (length - m + 1);
+    const char* p = text + start;
+    while (p < end) {
+        p = static_cast<const char*>(memchr(p, first, end - p));
+        if (!p) break;
+        if (p[m - 1] == last && (m <= 2 || memcmp(p + 1, pat.data() + 1, m - 2) == 0)) {
+            if (!sink.onMatch(offset + (p - text))) return false;
+        }
+        p++;
+    }
+    return true;
+}
+
+#ifdef SIMD_X86
+
+TARGET_SSE2 static size_t sse2Find(const char* text, size_t length, const string& pat,
+    size_t offset, MatchSink& sink, bool& stopped)
+{
+    size_t m = pat.size();
+    const __m128i first = _mm_set1_epi8(pat[0]);
+    const __m128i last = _mm_set1_epi8(pat[m - 1]);
+
+    size_t i = 0;
+    for (; i + m + 15 <= length; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last))));
+        while (mask) {
+            unsigned bit = lowestBit(mask);
+            if (m <= 2 || memcmp(text + i + bit + 1, pat.data() + 1, m - 2) == 0) {
+                if (!sink.onMatch(offset + i + bit)) {
+                    stopped = true;
+                    return i;
+                }
+            }
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t avx2Find(const char* text, size_t length, const string& pat,
+    size_t offset, MatchSink& sink, bool& stopped)
+{
+    size_t m = pat.size();
+    const __m256i first = _mm256_set1_epi8(pat[0]);
+    const __m256i last = _mm256_set1_epi8(pat[m - 1]);
+
+    size_t i = 0;
+    for (; i + m + 31 <= length; i += 32) {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last))));
+        while (mask) {
+            unsigned bit = lowestBit(mask);
+            if (m <= 2 || memcmp(text + i + bit + 1, pat.data() + 1, m - 2) == 0) {
+                if (!sink.onMatch(offset + i + bit)) {
+                    stopped = true;
+                    return i;
+                }
+            }
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+
+// Both strands share the block loads: the first/last bytes of the pattern and
+// of its reverse complement are compared against the same two registers.
+// sinks[s] is cleared once that strand's sink stops.
+TARGET_SSE2 static size_t sse2FindStrands(const char* text, size_t length, const string* pats[2],
+    size_t offset, MatchSink* sinks[2])
+{
+    size_t m = pats[0]->size();
+    const __m128i first[2] = { _mm_set1_epi8((*pats[0])[0]), _mm_set1_epi8((*pats[1])[0]) };
+    const __m128i last[2] = { _mm_set1_epi8((*pats[0])[m - 1]), _mm_set1_epi8((*pats[1])[m - 1]) };
+
+    size_t i = 0;
+    for (; i + m + 15 <= length; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1));
+        for (int s = 0; s < 2; s++) {
+            if (!sinks[s]) continue;
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(blockFirst, first[s]), _mm_cmpeq_epi8(blockLast, last[s]))));
+            while (mask) {
+                unsigned bit = lowestBit(mask);
+                if (m <= 2 || memcmp(text + i + bit + 1, pats[s]->data() + 1, m - 2) == 0) {
+                    if (!sinks[s]->onMatch(offset + i + bit)) {
+                        sinks[s] = nullptr;
+                        break;
+                    }
+                }
+                mask &= mask - 1;
+            }
+        }
+        if (!sinks[0] && !sinks[1]) return i;
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t avx2FindStrands(const char* text, size_t length, const string* pats[2],
+    size_t offset, MatchSink* sinks[2])
+{
+    size_t m = pats[0]->size();
+    const __m256i first[2] = { _mm256_set1_epi8((*pats[0])[0]), _mm256_set1_epi8((*pats[1])[0]) };
+    const __m256i last[2] = { _mm256_set1_epi8((*pats[0])[m - 1]), _mm256_set1_epi8((*pats[1])[m - 1]) };
+
+    size_t i = 0;
+    for (; i + m + 31 <= length; i += 32) {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1));
+        for (int s = 0; s < 2; s++) {
+            if (!sinks[s]) continue;
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first[s]), _mm256_cmpeq_epi8(blockLast, last[s]))));
+            while (mask) {
+                unsigned bit = lowestBit(mask);
+                if (m <= 2 || memcmp(text + i + bit + 1, pats[s]->data() + 1, m - 2) == 0) {
+                    if (!sinks[s]->onMatch(offset + i + bit)) {
+                        sinks[s] = nullptr;
+                        break;
+                    }
+                }
+                mask &= mask - 1;
+            }
+        }
+        if (!sinks[0] && !sinks[1]) return i;
+    }
+    return i;
+}
+
+#endif
+
+SimdSearch::Backend SimdSearch::detect() {
+#if defined(SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    if (osAvx && maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) return AVX2;
+    }
+    return sse2 ? SSE2 : SCALAR;
+#elif defined(SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return AVX2;
+    if (__builtin_cpu_supports("sse2")) return SSE2;
+    return SCALAR;
+#else
+    return SCALAR;
+#endif
+}
+
+SimdSearch::Backend SimdSearch::active() {
+    static const Backend backend = detect();
+    return backend;
+}
+
+const char* SimdSearch::backendName(Backend backend) {
+    switch (backend) {
+    case AVX2: return "AVX2";
+    case SSE2: return "SSE2";
+    default: return "Scalar";
+    }
+}
+
+bool SimdSearch::find(const char* text, size_t length, const string& pat, size_t offset,
+    MatchSink& sink, Backend backend)
+{
+    if (pat.empty() || length < pat.size()) return true;
+
+    size_t done = 0;
+    bool stopped = false;
+#ifdef SIMD_X86
+    if (backend == AVX2) done = avx2Find(text, length, pat, offset, sink, stopped);
+    else if (backend == SSE2) done = sse2Find(text, length, pat, offset, sink, stopped);
+#else
+    (void)backend;
+#endif
+    if (stopped) return false;
+    return scalarFind(text, length, pat, done, offset, sink);
+}
+
+bool SimdSearch::findStrands(const char* text, size_t length, const string& pat, const string& rc,
+    size_t offset, MatchSink*& plusSink, MatchSink*& minusSink, Backend backend)
+{
+    if (pat.empty() || pat.size() != rc.size() || length < pat.size()) return true;
+
+    const string* pats[2] = { &pat, &rc };
+    MatchSink* sinks[2] = { plusSink, minusSink };
+    size_t done = 0;
+#ifdef SIMD_X86
+    if (backend == AVX2) done = avx2FindStrands(text, length, pats, offset, sinks);
+    else if (backend == SSE2) done = sse2FindStrands(text, length, pats, offset, sinks);
+#else
+    (void)backend;
+#endif
+    for (int s = 0; s < 2; s++) {
+        if (sinks[s] && !scalarFind(text, length, *pats[s], done, offset, *sinks[s])) sinks[s] = nullptr;
+    }
+    plusSink = sinks[0];
+    minusSink = sinks[1];
+    return sinks[0] || sinks[1];
+}
+
+void SimdSearch::find(const char* text, size_t length, const string& pat, size_t offset,
+    vector<size_t>& out, Backend backend)
+{
+    VectorSink sink(out);
+    find(text, length, pat, offset, sink, backend);
+}
\ No newline at end of file
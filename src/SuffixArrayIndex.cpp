@@ -0,0 +1,369 @@
+#include "SuffixArrayIndex.h"
+#include "PackedSequence.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+    const uint32_t EMPTY = UINT32_MAX;
+    const char SA_MAGIC[8] = { 'D', 'N', 'A', 'S', 'A', 'I', 'X', '1' };
+
+    struct SAFileHeader {
+        char magic[8];
+        uint64_t length;
+        uint64_t textHash;
+        uint64_t hasLcp;
+    };
+
+    // Type bits: 1 = S-type, 0 = L-type.
+    class TypeBits {
+    private:
+        vector<uint8_t> bits;
+    public:
+        explicit TypeBits(size_t n) : bits((n + 7) / 8, 0) {}
+        bool get(size_t i) const { return (bits[i >> 3] >> (i & 7)) & 1; }
+        void set(size_t i, bool s) {
+            if (s) bits[i >> 3] |= static_cast<uint8_t>(1u << (i & 7));
+            else bits[i >> 3] &= static_cast<uint8_t>(~(1u << (i & 7)));
+        }
+        bool isLMS(size_t i) const { return i > 0 && get(i) && !get(i - 1); }
+    };
+
+    template <typename Char>
+    void getBuckets(const Char* s, vector<uint32_t>& bkt, size_t n, size_t K, bool end) {
+        fill(bkt.begin(), bkt.begin() + K + 1, 0);
+        for (size_t i = 0; i < n; i++) bkt[s[i]]++;
+        uint32_t sum = 0;
+        for (size_t i = 0; i <= K; i++) {
+            sum += bkt[i];
+            bkt[i] = end ? sum : sum - bkt[i];
+        }
+    }
+
+    template <typename Char>
+    void induceL(const TypeBits& t, uint32_t* SA, const Char* s, vector<uint32_t>& bkt, size_t n, size_t K) {
+        getBuckets(s, bkt, n, K, false);
+        for (size_t i = 0; i < n; i++) {
+            if (SA[i] == EMPTY || SA[i] == 0) continue;
+            uint32_t j = SA[i] - 1;
+            if (!t.get(j)) SA[bkt[s[j]]++] = j;
+        }
+    }
+
+    template <typename Char>
+    void induceS(const TypeBits& t, uint32_t* SA, const Char* s, vector<uint32_t>& bkt, size_t n, size_t K) {
+        getBuckets(s, bkt, n, K, true);
+        for (size_t i = n; i-- > 0; ) {
+            if (SA[i] == EMPTY || SA[i] == 0) continue;
+            uint32_t j = SA[i] - 1;
+            if (t.get(j)) SA[--bkt[s[j]]] = j;
+        }
+    }
+
+    // SA-IS (Nong, Zhang & Chan). s[n-1] must be a unique, smallest sentinel 0
+    // and every symbol must be in [0, K].
+    template <typename Char>
+    void sais(const Char* s, uint32_t* SA, size_t n, size_t K) {
+        TypeBits t(n);
+        t.set(n - 1, true);
+        if (n >= 2) t.set(n - 2, false);
+        for (size_t i = n - 2; i-- > 0; ) {
+            t.set(i, s[i] < s[i + 1] || (s[i] == s[i + 1] && t.get(i + 1)));
+        }
+
+        vector<uint32_t> bkt(K + 1);
+        getBuckets(s, bkt, n, K, true);
+        fill(SA, SA + n, EMPTY);
+        for (size_t i = 1; i < n; i++) {
+            if (t.isLMS(i)) SA[--bkt[s[i]]] = static_cast<uint32_t>(i);
+        }
+        induceL(t, SA, s, bkt, n, K);
+        induceS(t, SA, s, bkt, n, K);
+
+        size_t n1 = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (t.isLMS(SA[i])) SA[n1++] = SA[i];
+        }
+
+        fill(SA + n1, SA + n, EMPTY);
+        uint32_t name = 0;
+        uint32_t prev = EMPTY;
+        for (size_t i = 0; i < n1; i++) {
+            uint32_t pos = SA[i];
+            bool diff = false;
+            for (size_t d = 0; d < n; d++) {
+                if (prev == EMPTY || s[pos + d] != s[prev + d] || t.get(pos + d) != t.get(prev + d)) {
+                    diff = true;
+                    break;
+                }
+                if (d > 0 && (t.isLMS(pos + d) || t.isLMS(prev + d))) break;
+            }
+            if (diff) {
+                name++;
+                prev = pos;
+            }
+            SA[n1 + pos / 2] = name - 1;
+        }
+        for (size_t i = n, j = n; i-- > n1; ) {
+            if (SA[i] != EMPTY) SA[--j] = SA[i];
+        }
+
+        uint32_t* s1 = SA + n - n1;
+        if (name < n1) {
+            sais(s1, SA, n1, name - 1);
+        }
+        else {
+            for (size_t i = 0; i < n1; i++) SA[s1[i]] = static_cast<uint32_t>(i);
+        }
+
+        getBuckets(s, bkt, n, K, true);
+        for (size_t i = 1, j = 0; i < n; i++) {
+            if (t.isLMS(i)) s1[j++] = static_cast<uint32_t>(i);
+        }
+        for (size_t i = 0; i < n1; i++) SA[i] = s1[SA[i]];
+        fill(SA + n1, SA + n, EMPTY);
+        for (size_t i = n1; i-- > 0; ) {
+            uint32_t j = SA[i];
+            SA[i] = EMPTY;
+            SA[--bkt[s[j]]] = j;
+        }
+        induceL(t, SA, s, bkt, n, K);
+        induceS(t, SA, s, bkt, n, K);
+    }
+
+    // Symbol ranks used for both construction and queries: $ < A < C < G < T < N.
+    int symbolRank(char c) {
+        switch (c) {
+        case 'A': return 1;
+        case 'C': return 2;
+        case 'G': return 3;
+        case 'T': return 4;
+        case 'N': return 5;
+        default: return 6;
+        }
+    }
+}
+
+SuffixArrayIndex::SuffixArrayIndex() : sa(nullptr), lcp(nullptr), length(0), textHash(0) {}
+
+uint64_t SuffixArrayIndex::fingerprint(const PackedSequence& text) {
+    uint64_t hash = 1469598103934665603ULL ^ text.size();
+    for (size_t w = 0; w < text.wordCount(); w++) {
+        hash = (hash ^ text.word(w)) * 1099511628211ULL;
+    }
+    for (const NRun& run : text.getNRuns()) {
+        hash = (hash ^ run.start) * 1099511628211ULL;
+        hash = (hash ^ run.length) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+void SuffixArrayIndex::clear() {
+    saData.clear();
+    saData.shrink_to_fit();
+    lcpData.clear();
+    lcpData.shrink_to_fit();
+    mapped.close();
+    sa = nullptr;
+    lcp = nullptr;
+    length = 0;
+    textHash = 0;
+}
+
+bool SuffixArrayIndex::build(const PackedSequence& text, bool withLcp) {
+    clear();
+    size_t n = text.size();
+    if (n == 0 || n >= EMPTY - 1) {
+        cerr << "Error: Suffix array supports 1 to " << (EMPTY - 2) << " bases\n";
+        return false;
+    }
+
+    vector<uint8_t> symbols(n + 1);
+    for (size_t i = 0; i < n; i++) {
+        symbols[i] = static_cast<uint8_t>(text.isN(i) ? 5 : text.code(i) + 1);
+    }
+    symbols[n] = 0;
+
+    // Built in place; saData[0] is the sentinel suffix and is shifted out, so
+    // there is never a second n-word copy.
+    saData.resize(n + 1);
+    sais(symbols.data(), saData.data(), n + 1, 5);
+    saData.erase(saData.begin());
+
+    if (withLcp) {
+        vector<uint32_t> rank(n);
+        for (size_t i = 0; i < n; i++) rank[saData[i]] = static_cast<uint32_t>(i);
+
+        lcpData.assign(n, 0);
+        size_t h = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (rank[i] == 0) {
+                h = 0;
+                continue;
+            }
+            size_t j = saData[rank[i] - 1];
+            while (i + h < n && j + h < n && symbols[i + h] == symbols[j + h]) h++;
+            lcpData[rank[i]] = static_cast<uint32_t>(h);
+            if (h > 0) h--;
+        }
+    }
+
+    sa = saData.data();
+    lcp = withLcp ? lcpData.data() : nullptr;
+    length = n;
+    textHash = fingerprint(text);
+    return true;
+}
+
+bool SuffixArrayIndex::save(const string& filename) const {
+    if (!isBuilt()) return false;
+
+    ofstream out(filename, ios::binary);
+    if (!out.is_open()) {
+        cerr << "Error: Could not write index: " << filename << '\n';
+        return false;
+    }
+
+    SAFileHeader header;
+    memcpy(header.magic, SA_MAGIC, sizeof(SA_MAGIC));
+    header.length = length;
+    header.textHash = textHash;
+    header.hasLcp = hasLcp() ? 1 : 0;
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(sa), length * sizeof(uint32_t));
+    if (hasLcp()) {
+        out.write(reinterpret_cast<const char*>(lcp), length * sizeof(uint32_t));
+    }
+    return static_cast<bool>(out);
+}
+
+bool SuffixArrayIndex::load(const string& filename) {
+    clear();
+    if (!mapped.open(filename) || mapped.size() < sizeof(SAFileHeader)) {
+        cerr << "Error: Could not map index: " << filename << '\n';
+        mapped.close();
+        return false;
+    }
+
+    SAFileHeader header;
+    memcpy(&header, mapped.getData(), sizeof(header));
+    size_t arrays = header.hasLcp ? 2 : 1;
+    if (memcmp(header.magic, SA_MAGIC, sizeof(SA_MAGIC)) != 0 ||
+        mapped.size() != sizeof(header) + arrays * header.length * sizeof(uint32_t)) {
+        cerr << "Error: Not a suffix array index: " << filename << '\n';
+        mapped.close();
+        return false;
+    }
+
+    const uint32_t* body = reinterpret_cast<const uint32_t*>(mapped.getData() + sizeof(header));
+    length = static_cast<size_t>(header.length);
+    textHash = header.textHash;
+    sa = body;
+    lcp = header.hasLcp ? body + length : nullptr;
+    return true;
+}
+
+bool SuffixArrayIndex::matches(const PackedSequence& text) const {
+    return isBuilt() && text.size() == length && fingerprint(text) == textHash;
+}
+
+size_t SuffixArrayIndex::memoryUsage() const {
+    return (hasLcp() ? 2 : 1) * length * sizeof(uint32_t);
+}
+
+// Compares the suffix at pos with pat, skipping the first `skip` characters
+// already known to match. Returns <0, 0 (pat is a prefix) or >0.
+int SuffixArrayIndex::compareSuffix(const PackedSequence& text, uint32_t pos, const string& pat,
+    size_t skip, size_t& matched) const
+{
+    size_t i = skip;
+    while (i < pat.size()) {
+        if (pos + i >= length) {
+            matched = i;
+            return -1;
+        }
+        int a = symbolRank(text[pos + i]);
+        int b = symbolRank(pat[i]);
+        if (a != b) {
+            matched = i;
+            return a < b ? -1 : 1;
+        }
+        i++;
+    }
+    matched = i;
+    return 0;
+}
+
+// Binary search with the mlr accelerant: characters shared by both bounds
+// are not compared again.
+pair<size_t, size_t> SuffixArrayIndex::findRange(const PackedSequence& text, const string& pat) const {
+    if (!isBuilt() || pat.empty() || pat.size() > length) return { 0, 0 };
+
+    size_t lo = 0, hi = length;
+    size_t lcpLo = 0, lcpHi = 0;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t matched;
+        int cmp = compareSuffix(text, sa[mid], pat, min(lcpLo, lcpHi), matched);
+        if (cmp < 0) {
+            lo = mid + 1;
+            lcpLo = matched;
+        }
+        else {
+            hi = mid;
+            lcpHi = matched;
+        }
+    }
+    size_t first = lo;
+
+    hi = length;
+    lcpLo = lcpHi = 0;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t matched;
+        int cmp = compareSuffix(text, sa[mid], pat, min(lcpLo, lcpHi), matched);
+        if (cmp <= 0) {
+            lo = mid + 1;
+            lcpLo = matched;
+        }
+        else {
+            hi = mid;
+            lcpHi = matched;
+        }
+    }
+    return { first, lo };
+}
+
+size_t SuffixArrayIndex::count(const PackedSequence& text, const string& pat) const {
+    auto range = findRange(text, pat);
+    return range.second - range.first;
+}
+
+vector<size_t> SuffixArrayIndex::locate(const PackedSequence& text, const string& pat) const {
+    auto range = findRange(text, pat);
+    vector<size_t> result;
+    result.reserve(range.second - range.first);
+    for (size_t i = range.first; i < range.second; i++) {
+        result.push_back(sa[i]);
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+size_t SuffixArrayIndex::longestRepeat(size_t& position) const {
+    position = 0;
+    if (!hasLcp()) return 0;
+
+    size_t best = 0;
+    for (size_t i = 1; i < length; i++) {
+        if (lcp[i] > best) {
+            best = lcp[i];
+            position = sa[i];
+        }
+    }
+    return best;
+}
\ No newline at end of file
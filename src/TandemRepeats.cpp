@@ -0,0 +1,200 @@
+#include "TandemRepeats.h"
+#include "PackedSequence.h"
+#include "MatchSink.h"
+#include "ParallelJobs.h"
+#include <algorithm>
+#include <bit>
+#include <thread>
+
+using namespace std;
+
+static const size_t CHUNK_BASES = 1 << 22;
+static const size_t BLOCK = PackedSequence::BASES_PER_WORD;
+static const uint64_t LOW_BITS = 0x5555555555555555ULL;
+static const int MATCH_SCORE = 2;
+static const int MISMATCH_SCORE = -7;
+static const int X_DROP = 14;
+static const size_t SEED = 8;
+
+static uint64_t baseMask(size_t bases) {
+    return bases >= BLOCK ? ~0ULL : (1ULL << (2 * bases)) - 1;
+}
+
+// True if the unit repeats with a shorter period dividing its length.
+static bool isPeriodic(uint64_t unit, unsigned period) {
+    for (unsigned d = 1; d < period; d++) {
+        if (period % d != 0) continue;
+        if (((unit ^ (unit >> (2 * d))) & baseMask(period - d)) == 0) return true;
+    }
+    return false;
+}
+
+string TandemRepeat::unitString() const {
+    static const char BASES[4] = { 'A', 'C', 'G', 'T' };
+    string text(period, 'A');
+    for (unsigned i = 0; i < period; i++) text[i] = BASES[(unit >> (2 * i)) & 3];
+    return text;
+}
+
+TandemRepeats::TandemRepeats(const PackedSequence& sequence, const vector<RecordRange>& recordRanges,
+    const TandemRepeatParams& repeatParams, unsigned threads)
+    : seq(sequence), ranges(recordRanges), params(repeatParams), threadCount(threads),
+    nextJob(0), lastRange(SIZE_MAX), lastEnd(MAX_PERIOD + 1, 0)
+{
+    params.minPeriod = max(1u, params.minPeriod);
+    params.maxPeriod = min(MAX_PERIOD, params.maxPeriod);
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+
+    for (size_t r = 0; r < ranges.size(); r++) {
+        for (size_t begin = ranges[r].begin; begin < ranges[r].end; begin += CHUNK_BASES) {
+            jobs.push_back({ r, begin, min(ranges[r].end, begin + CHUNK_BASES) });
+        }
+    }
+}
+
+void TandemRepeats::scanPeriod(const Job& job, unsigned period, vector<TandemRepeat>& out) const {
+    const RecordRange& range = ranges[job.range];
+    if (range.end - range.begin <= period) return;
+    const size_t lastCompare = range.end - period;   // comparisons j < lastCompare
+    const size_t limit = min(job.end, lastCompare);
+    if (job.begin >= limit) return;
+
+    auto same = [&](size_t j) {
+        return seq.code(j) == seq.code(j + period) && !seq.isN(j) && !seq.isN(j + period);
+    };
+
+    // Seeds are runs of SEED equal comparisons ending inside the job; one block
+    // before it is scanned only to carry runs in.
+    size_t scanFrom = job.begin >= range.begin + BLOCK ? job.begin - BLOCK : range.begin;
+    uint64_t prevEq = 0, prevR1 = 0, prevR2 = 0;
+    size_t covered = 0;
+    for (size_t i = scanFrom; i < limit; i += BLOCK) {
+        size_t lanes = min(BLOCK, limit - i);
+        uint64_t diff = seq.wordAt(i) ^ seq.wordAt(i + period);
+        uint64_t eq = ~(diff | (diff >> 1)) & LOW_BITS & baseMask(lanes);
+
+        // N slots hold A, so lanes reading an N must not count as equal.
+        if (eq != 0) {
+            for (size_t w = i / BLOCK; w <= (i + lanes - 1 + period) / BLOCK; w++) {
+                if (!seq.wordHasN(w)) continue;
+                for (size_t k = 0; k < lanes; k++) {
+                    if (seq.isN(i + k) || seq.isN(i + k + period)) eq &= ~(1ULL << (2 * k));
+                }
+                break;
+            }
+        }
+
+        uint64_t r1 = eq & ((eq << 2) | (prevEq >> 62));
+        uint64_t r2 = r1 & ((r1 << 4) | (prevR1 >> 60));
+        uint64_t seeds = r2 & ((r2 << 8) | (prevR2 >> 56));
+        prevEq = eq;
+        prevR1 = r1;
+        prevR2 = r2;
+        if (i < job.begin || seeds == 0) continue;
+        if (covered > i) seeds &= covered - i >= BLOCK ? 0 : ~baseMask(covered - i);
+
+        while (seeds != 0) {
+            size_t seedEnd = i + countr_zero(seeds) / 2;
+            seeds &= seeds - 1;
+            if (seedEnd < covered) continue;
+
+            int score = 0, right = 0;
+            size_t last = seedEnd;
+            for (size_t j = seedEnd + 1; j < lastCompare; j++) {
+                score += same(j) ? MATCH_SCORE : MISMATCH_SCORE;
+                if (score > right) {
+                    right = score;
+                    last = j;
+                }
+                else if (score < right - X_DROP) break;
+            }
+
+            score = 0;
+            int left = 0;
+            size_t first = seedEnd + 1 - SEED;
+            for (size_t j = first; j > range.begin; ) {
+                j--;
+                score += same(j) ? MATCH_SCORE : MISMATCH_SCORE;
+                if (score > left) {
+                    left = score;
+                    first = j;
+                }
+                else if (score < left - X_DROP) break;
+            }
+
+            covered = last + 1;
+            size_t compared = last + 1 - first;
+            int total = static_cast<int>(SEED) * MATCH_SCORE + left + right;
+            size_t length = compared + period;
+            if (total < params.minScore || static_cast<double>(length) / period < params.minCopies) continue;
+
+            uint64_t unit = seq.wordAt(first) & baseMask(period);
+            if (isPeriodic(unit, period)) continue;
+
+            size_t matches = static_cast<size_t>((total - MISMATCH_SCORE * static_cast<long long>(compared))
+                / (MATCH_SCORE - MISMATCH_SCORE));
+            out.push_back({ range.record, first, first + length, period, total, matches, unit });
+        }
+    }
+}
+
+void TandemRepeats::scanJob(const Job& job, vector<TandemRepeat>& out) const {
+    for (unsigned period = params.minPeriod; period <= params.maxPeriod; period++) {
+        scanPeriod(job, period, out);
+    }
+    sort(out.begin(), out.end(), [](const TandemRepeat& a, const TandemRepeat& b) {
+        return a.start != b.start ? a.start < b.start : a.period < b.period;
+    });
+}
+
+bool TandemRepeats::nextBatch(vector<TandemRepeat>& out) {
+    out.clear();
+    if (nextJob >= jobs.size()) return false;
+
+    size_t batchStart = nextJob;
+    size_t batchEnd = min(jobs.size(), batchStart + static_cast<size_t>(threadCount) * 2);
+    nextJob = batchEnd;
+
+    vector<vector<TandemRepeat>> found(batchEnd - batchStart);
+    ParallelJobs::run(batchStart, batchEnd, threadCount, [&](size_t j) {
+        scanJob(jobs[j], found[j - batchStart]);
+    });
+
+    // A repeat crossing a chunk boundary is found from both sides; keep the first.
+    // Neighbours of one period may share up to period bases, as within a chunk.
+    for (size_t j = batchStart; j < batchEnd; j++) {
+        if (jobs[j].range != lastRange) {
+            lastRange = jobs[j].range;
+            fill(lastEnd.begin(), lastEnd.end(), 0);
+        }
+        for (const TandemRepeat& repeat : found[j - batchStart]) {
+            if (repeat.start + repeat.period < lastEnd[repeat.period]) continue;
+            lastEnd[repeat.period] = repeat.end;
+            out.push_back(repeat);
+        }
+    }
+    return true;
+}
+
+void TandemRepeats::writeLine(const TandemRepeat& repeat, const vector<FastaRecord>& records,
+    size_t storeOffset, BufferedWriter& out)
+{
+    const FastaRecord& record = records[repeat.record];
+    size_t start = storeOffset + repeat.start - record.offset + record.start;
+    out.append(record.name);
+    out.append('\t');
+    out.append(start);
+    out.append('\t');
+    out.append(start + repeat.length());
+    out.append('\t');
+    out.append(repeat.unitString());
+    out.append('\t');
+    out.append(static_cast<size_t>(repeat.period));
+    out.append('\t');
+    out.append(repeat.copies(), 1);
+    out.append('\t');
+    out.append(repeat.purity(), 1);
+    out.append('\t');
+    out.append(static_cast<size_t>(repeat.score));
+    out.append('\n');
+}
\ No newline at end of file